@@ -0,0 +1,57 @@
+#-------------------------------------------------
+#
+# Application sources without main(), shared by the
+# GUI target and the test targets
+#
+#-------------------------------------------------
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/mainwindow.cpp \
+    $$PWD/layermodel.cpp \
+    $$PWD/xmltools.cpp \
+    $$PWD/variable.cpp \
+    $$PWD/settings.cpp \
+    $$PWD/textlayer.cpp \
+    $$PWD/designer.cpp \
+    $$PWD/imagelayer.cpp \
+    $$PWD/designermodel.cpp \
+    $$PWD/shapelayer.cpp \
+    $$PWD/commandline.cpp \
+    $$PWD/daemon.cpp \
+    $$PWD/imageloader.cpp \
+    $$PWD/undocommands.cpp \
+    $$PWD/bezellayer.cpp
+
+HEADERS += \
+    $$PWD/mainwindow.h \
+    $$PWD/pixmaplabel.h \
+    $$PWD/layermodel.h \
+    $$PWD/xmltools.h \
+    $$PWD/main.h \
+    $$PWD/variable.h \
+    $$PWD/variableentry.h \
+    $$PWD/widget.h \
+    $$PWD/settings.h \
+    $$PWD/slider.h \
+    $$PWD/textlayer.h \
+    $$PWD/designer.h \
+    $$PWD/designerlayer.h \
+    $$PWD/imagelayer.h \
+    $$PWD/designermodel.h \
+    $$PWD/shapelayer.h \
+    $$PWD/commandline.h \
+    $$PWD/daemon.h \
+    $$PWD/daemonprotocol.h \
+    $$PWD/imageloader.h \
+    $$PWD/undocommands.h \
+    $$PWD/bezellayer.h
+
+FORMS += \
+    $$PWD/mainwindow.ui \
+    $$PWD/settings.ui \
+    $$PWD/designer.ui
+
+RESOURCES += \
+    $$PWD/resources.qrc
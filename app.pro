@@ -0,0 +1,44 @@
+#-------------------------------------------------
+#
+# Project created by QtCreator 2018-07-10T08:49:25
+#
+#-------------------------------------------------
+
+QT       += core gui concurrent network
+win32:RC_FILE = icon.rc
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = BurningIcon
+TEMPLATE = app
+VERSION = 1.0.0
+DEFINES += APP_VERSION=\\\"$$VERSION\\\"
+
+# The following define makes your compiler emit warnings if you use
+# any feature of Qt which as been marked as deprecated (the exact warnings
+# depend on your compiler). Please consult the documentation of the
+# deprecated API in order to know how to port your code away from it.
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# You can also make your code fail to compile if you use deprecated APIs.
+# In order to do so, uncomment the following line.
+# You can also select to disable deprecated APIs only up to a certain version of Qt.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+# link against the core library
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/release/ -lburningicon
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/debug/ -lburningicon
+else:unix: LIBS += -L$$OUT_PWD/ -lburningicon
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/release/libburningicon.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/debug/libburningicon.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/release/burningicon.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/debug/burningicon.lib
+else:unix: PRE_TARGETDEPS += $$OUT_PWD/libburningicon.a
+
+
+# application sources (shared with the test targets)
+include(app.pri)
+
+SOURCES += \
+        main.cpp
@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "atlas.h"
+#include "trace.h"
+#include <QBuffer>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtMath>
+#include <algorithm>
+
+/**
+ * @brief Atlas::add queues layers for packing
+ * @param layers
+ * @param name prefix of entry names (defaults to "icon")
+ */
+void Atlas::add( const QList<Layer*> &layers, const QString &name ) {
+    const QString prefix( name.isEmpty() ? "icon" : name );
+
+    foreach ( const Layer *layer, layers ) {
+        if ( layer->image().isNull())
+            continue;
+
+        Item item;
+        item.entry = AtlasEntry( QString( "%1_%2%3" ).arg( prefix ).arg( layer->scale()).arg( layer->isDoubleScale() ? "@2x" : "" ), layer->scale(), layer->isDoubleScale());
+        item.image = layer->image().convertToFormat( QImage::Format_RGBA8888 );
+        item.entry.rect = QRect( QPoint( 0, 0 ), item.image.size());
+        this->m_items << item;
+    }
+}
+
+/**
+ * @brief Atlas::place runs the shelf packer for a given texture size
+ * @param width
+ * @param height
+ * @return false if items do not fit
+ */
+bool Atlas::place( int width, int height ) {
+    const int padding = this->m_options.padding;
+    int x = 0, y = 0, shelf = 0;
+
+    for ( int i = 0; i < this->m_items.count(); i++ ) {
+        Item &item = this->m_items[i];
+        const int w = item.image.width() + padding * 2;
+        const int h = item.image.height() + padding * 2;
+
+        // start a new shelf
+        if ( x + w > width ) {
+            x = 0;
+            y += shelf;
+            shelf = 0;
+        }
+
+        if ( x + w > width || y + h > height )
+            return false;
+
+        item.entry.rect = QRect( x + padding, y + padding, item.image.width(), item.image.height());
+        x += w;
+        shelf = qMax( shelf, h );
+    }
+
+    return true;
+}
+
+/**
+ * @brief Atlas::pack packs all queued layers and renders the texture
+ * @return false if they do not fit into the maximum texture size
+ */
+bool Atlas::pack() {
+    const TraceScope trace( "Atlas::pack" );
+    const int padding = this->m_options.padding;
+    qint64 area = 0;
+    int widest = 1, tallest = 1;
+
+    if ( this->m_items.isEmpty())
+        return false;
+
+    // tallest first keeps shelves dense
+    std::stable_sort( this->m_items.begin(), this->m_items.end(), []( const Item &left, const Item &right ) {
+        return left.image.height() > right.image.height();
+    } );
+
+    foreach ( const Item &item, this->m_items ) {
+        area += static_cast<qint64>( item.image.width() + padding * 2 ) * ( item.image.height() + padding * 2 );
+        widest = qMax( widest, item.image.width() + padding * 2 );
+        tallest = qMax( tallest, item.image.height() + padding * 2 );
+    }
+
+    // smallest power of two that could hold the total area, then grow
+    int width = static_cast<int>( qNextPowerOfTwo( static_cast<quint32>( qMax( widest, qCeil( qSqrt( static_cast<qreal>( area ))))) - 1 ));
+    int height = static_cast<int>( qNextPowerOfTwo( static_cast<quint32>( tallest ) - 1 ));
+    height = qMax( height, width / 2 );
+
+    while ( !this->place( width, height )) {
+        if ( width <= height )
+            width *= 2;
+        else
+            height *= 2;
+
+        if ( width > Atlas_::MaximumSize || height > Atlas_::MaximumSize ) {
+            qCCritical( Atlas_::Debug ) << "layers do not fit into" << Atlas_::MaximumSize << "x" << Atlas_::MaximumSize;
+            this->m_image = QImage();
+            return false;
+        }
+    }
+
+    this->m_image = QImage( width, height, QImage::Format_RGBA8888 );
+    this->m_image.fill( Qt::transparent );
+    foreach ( const Item &item, this->m_items )
+        this->blit( item );
+
+    return true;
+}
+
+/**
+ * @brief Atlas::blit copies an item (and its extruded edges) into the texture
+ * @param item
+ */
+void Atlas::blit( const Item &item ) {
+    const QRect &rect = item.entry.rect;
+    const int border = this->m_options.extrude ? this->m_options.padding : 0;
+    const int w = item.image.width();
+    const int h = item.image.height();
+
+    for ( int y = -border; y < h + border; y++ ) {
+        const quint32 *source = reinterpret_cast<const quint32*>( item.image.constScanLine( qBound( 0, y, h - 1 )));
+        quint32 *target = reinterpret_cast<quint32*>( this->m_image.scanLine( rect.y() + y ));
+
+        // clamp coordinates, so the border repeats the edge pixels
+        for ( int x = -border; x < w + border; x++ )
+            target[rect.x() + x] = source[qBound( 0, x, w - 1 )];
+    }
+}
+
+/**
+ * @brief Atlas::entries returns packed rectangles
+ * @return
+ */
+QList<AtlasEntry> Atlas::entries() const {
+    QList<AtlasEntry> entries;
+
+    foreach ( const Item &item, this->m_items )
+        entries << item.entry;
+
+    return entries;
+}
+
+/**
+ * @brief Atlas::toJson returns the rectangle index as JSON
+ * @param imageName
+ * @return
+ */
+QJsonDocument Atlas::toJson( const QString &imageName ) const {
+    QJsonObject object;
+    QJsonArray entries;
+
+    foreach ( const Item &item, this->m_items ) {
+        QJsonObject entry;
+
+        entry["name"] = item.entry.name;
+        entry["scale"] = item.entry.scale;
+        entry["doubleScale"] = item.entry.doubleScale;
+        entry["x"] = item.entry.rect.x();
+        entry["y"] = item.entry.rect.y();
+        entry["width"] = item.entry.rect.width();
+        entry["height"] = item.entry.rect.height();
+        entries << entry;
+    }
+
+    if ( !imageName.isEmpty())
+        object["image"] = imageName;
+    object["width"] = this->m_image.width();
+    object["height"] = this->m_image.height();
+    object["padding"] = this->m_options.padding;
+    object["extrude"] = this->m_options.extrude;
+    object["entries"] = entries;
+
+    return QJsonDocument( object );
+}
+
+/**
+ * @brief Atlas::toBinary returns the rectangle index in a compact little endian form
+ * @return
+ *
+ * Layout: magic, version (u16), entry count (u16), width, height (u16 each),
+ * then per entry x, y, width, height, scale (u16 each), flags (u8, bit 0 is
+ * doubleScale) and a length-prefixed (u8) UTF-8 name.
+ */
+QByteArray Atlas::toBinary() const {
+    QByteArray bytes;
+    QDataStream out( &bytes, QIODevice::WriteOnly );
+
+    out.setByteOrder( QDataStream::LittleEndian );
+    out << Atlas_::Magic << Atlas_::Version << static_cast<quint16>( this->m_items.count())
+        << static_cast<quint16>( this->m_image.width()) << static_cast<quint16>( this->m_image.height());
+
+    foreach ( const Item &item, this->m_items ) {
+        const QByteArray name( item.entry.name.toUtf8().left( 255 ));
+
+        out << static_cast<quint16>( item.entry.rect.x()) << static_cast<quint16>( item.entry.rect.y())
+            << static_cast<quint16>( item.entry.rect.width()) << static_cast<quint16>( item.entry.rect.height())
+            << static_cast<quint16>( item.entry.scale ) << static_cast<quint8>( item.entry.doubleScale ? 1 : 0 )
+            << static_cast<quint8>( name.size());
+        out.writeRawData( name.constData(), name.size());
+    }
+
+    return bytes;
+}
+
+/**
+ * @brief Atlas::write writes the texture as png with .json and .bin indexes next to it
+ * @param fileName
+ * @return
+ */
+bool Atlas::write( const QString &fileName ) const {
+    const QFileInfo info( fileName );
+    const QString base( info.absolutePath() + "/" + info.completeBaseName());
+    const QByteArray json( this->toJson( info.fileName()).toJson( QJsonDocument::Compact ));
+    const QByteArray binary( this->toBinary());
+    QByteArray png;
+
+    if ( this->m_image.isNull())
+        return false;
+
+    {
+        QBuffer buffer( &png );
+        buffer.open( QIODevice::WriteOnly );
+        if ( !this->m_image.save( &buffer, "PNG" ))
+            return false;
+    }
+
+    QSaveFile imageFile( fileName ), jsonFile( base + ".json" ), binaryFile( base + ".bin" );
+    return imageFile.open( QIODevice::WriteOnly ) && imageFile.write( png ) == png.size() && imageFile.commit() &&
+            jsonFile.open( QIODevice::WriteOnly ) && jsonFile.write( json ) == json.size() && jsonFile.commit() &&
+            binaryFile.open( QIODevice::WriteOnly ) && binaryFile.write( binary ) == binary.size() && binaryFile.commit();
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+#pragma once
+
+//
+// includes
+//
+#include <QImage>
+#include <QJsonDocument>
+#include <QList>
+#include <QLoggingCategory>
+#include <QRect>
+#include <QString>
+#include "layer.h"
+
+/**
+ * @brief The Atlas_ namespace
+ */
+namespace Atlas_ {
+const static QLoggingCategory Debug( "atlas" );
+constexpr int MaximumSize = 8192;
+constexpr quint32 Magic = 0x54414942; // "BIAT" little endian
+constexpr quint16 Version = 1;
+}
+
+/**
+ * @brief The AtlasOptions struct
+ */
+struct AtlasOptions {
+    int padding;
+    bool extrude;
+    AtlasOptions( int p = 1, bool e = false ) : padding( p ), extrude( e ) {}
+};
+
+/**
+ * @brief The AtlasEntry struct is a single packed image
+ */
+struct AtlasEntry {
+    QString name;
+    int scale;
+    bool doubleScale;
+    QRect rect;
+    AtlasEntry( const QString &n = QString(), int s = 0, bool d = false ) : name( n ), scale( s ), doubleScale( d ) {}
+};
+
+/**
+ * @brief The Atlas class packs layers of one or more icons into a single power-of-two RGBA texture
+ *
+ * Rectangles are placed with a shelf packer (tallest first), growing the
+ * texture one power of two at a time until everything fits. Padding can be
+ * filled with the edge pixels (extrusion) to avoid bleeding when sampled
+ * with bilinear filtering.
+ */
+class Atlas final {
+public:
+    explicit Atlas( const AtlasOptions &options = AtlasOptions()) : m_options( options ) {}
+    ~Atlas() = default;
+    void add( const QList<Layer*> &layers, const QString &name = QString());
+    bool pack();
+    const QImage &image() const { return this->m_image; }
+    QList<AtlasEntry> entries() const;
+    QJsonDocument toJson( const QString &imageName = QString()) const;
+    QByteArray toBinary() const;
+    bool write( const QString &fileName ) const;
+
+private:
+    /**
+     * @brief The Item struct
+     */
+    struct Item {
+        AtlasEntry entry;
+        QImage image;
+    };
+    bool place( int width, int height );
+    void blit( const Item &item );
+    AtlasOptions m_options;
+    QList<Item> m_items;
+    QImage m_image;
+};
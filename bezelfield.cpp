@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "bezelfield.h"
+#include "trace.h"
+#include <QCache>
+#include <QMutex>
+#include <QtMath>
+
+/**
+ * @brief BezelStyle::operator ==
+ * @param other
+ * @return
+ */
+bool BezelStyle::operator==( const BezelStyle &other ) const {
+    return this->outline == other.outline &&
+            qFuzzyCompare( this->radius, other.radius ) &&
+            qFuzzyCompare( this->exponent, other.exponent ) &&
+            this->fill == other.fill &&
+            this->stroke == other.stroke &&
+            qFuzzyCompare( 1.0 + this->strokeWidth, 1.0 + other.strokeWidth ) &&
+            qFuzzyCompare( 1.0 + this->bevel, 1.0 + other.bevel ) &&
+            qFuzzyCompare( 1.0 + this->bevelStrength, 1.0 + other.bevelStrength ) &&
+            this->glow == other.glow &&
+            qFuzzyCompare( 1.0 + this->glowWidth, 1.0 + other.glowWidth );
+}
+
+/**
+ * @brief BezelField::BezelField samples the outline distance on a regular grid
+ * @param style
+ */
+BezelField::BezelField( const BezelStyle &style ) {
+    const TraceScope trace( "BezelField::build" );
+    const int resolution = BezelField_::Resolution;
+    const qreal step = 2.0 * BezelField_::Extent / ( resolution - 1 );
+
+    this->values.resize( resolution * resolution );
+    for ( int y = 0; y < resolution; y++ ) {
+        for ( int x = 0; x < resolution; x++ )
+            this->values[y * resolution + x] = static_cast<float>( BezelField::evaluate( style, -BezelField_::Extent + x * step, -BezelField_::Extent + y * step ));
+    }
+}
+
+/**
+ * @brief BezelField::shared returns the (cached) field of the outline in style
+ * @param style
+ * @return
+ */
+QSharedPointer<const BezelField> BezelField::shared( const BezelStyle &style ) {
+    static QMutex mutex;
+    static QCache<QString, QSharedPointer<const BezelField> > cache( 8 );
+    const QString key( QString( "%1:%2" ).arg( static_cast<int>( style.outline )).arg( style.outline == BezelStyle::Outlines::Squircle ? style.exponent : style.radius ));
+    QMutexLocker lock( &mutex );
+
+    if ( !cache.contains( key ))
+        cache.insert( key, new QSharedPointer<const BezelField>( new BezelField( style )));
+
+    return *cache.object( key );
+}
+
+/**
+ * @brief BezelField::evaluate computes the signed distance to the outline
+ * @param style
+ * @param x
+ * @param y
+ * @return
+ */
+qreal BezelField::evaluate( const BezelStyle &style, qreal x, qreal y ) {
+    const qreal ax = qAbs( x );
+    const qreal ay = qAbs( y );
+
+    if ( style.outline == BezelStyle::Outlines::Squircle ) {
+        // first order distance to the superellipse |x|^n + |y|^n = 1
+        const qreal n = qMax( 2.0, style.exponent );
+        const qreal sum = qPow( ax, n ) + qPow( ay, n );
+        if ( sum < 1e-12 )
+            return -1.0;
+
+        const qreal radius = qPow( sum, 1.0 / n );
+        const qreal gx = qPow( ax, n - 1.0 ) * qPow( radius, 1.0 - n );
+        const qreal gy = qPow( ay, n - 1.0 ) * qPow( radius, 1.0 - n );
+        return ( radius - 1.0 ) / qMax( 1e-6, qSqrt( gx * gx + gy * gy ));
+    }
+
+    // exact rounded rectangle distance
+    const qreal radius = qBound( 0.0, style.radius, 1.0 );
+    const qreal qx = ax - 1.0 + radius;
+    const qreal qy = ay - 1.0 + radius;
+    const qreal outside = qSqrt( qMax( qx, 0.0 ) * qMax( qx, 0.0 ) + qMax( qy, 0.0 ) * qMax( qy, 0.0 ));
+    return outside + qMin( qMax( qx, qy ), 0.0 ) - radius;
+}
+
+/**
+ * @brief BezelField::distance samples the field (bilinear) in outline units
+ * @param x
+ * @param y
+ * @return
+ */
+qreal BezelField::distance( qreal x, qreal y ) const {
+    const int resolution = BezelField_::Resolution;
+    const qreal scale = ( resolution - 1 ) / ( 2.0 * BezelField_::Extent );
+    const qreal gx = qBound( 0.0, ( x + BezelField_::Extent ) * scale, static_cast<qreal>( resolution - 1 ));
+    const qreal gy = qBound( 0.0, ( y + BezelField_::Extent ) * scale, static_cast<qreal>( resolution - 1 ));
+    const int x0 = qMin( static_cast<int>( gx ), resolution - 2 );
+    const int y0 = qMin( static_cast<int>( gy ), resolution - 2 );
+    const qreal fx = gx - x0;
+    const qreal fy = gy - y0;
+    const float *row( this->values.constData() + y0 * resolution + x0 );
+
+    return ( row[0] * ( 1.0 - fx ) + row[1] * fx ) * ( 1.0 - fy ) +
+            ( row[resolution] * ( 1.0 - fx ) + row[resolution + 1] * fx ) * fy;
+}
+
+/**
+ * @brief BezelField::gradient returns the (outward) field gradient
+ * @param x
+ * @param y
+ * @param dx
+ * @param dy
+ */
+void BezelField::gradient( qreal x, qreal y, qreal *dx, qreal *dy ) const {
+    const qreal step = 2.0 * BezelField_::Extent / ( BezelField_::Resolution - 1 );
+
+    *dx = this->distance( x + step, y ) - this->distance( x - step, y );
+    *dy = this->distance( x, y + step ) - this->distance( x, y - step );
+}
+
+/**
+ * @brief BezelField::render rasterizes a bezel at the given size in a single pass
+ * @param style
+ * @param size
+ * @return
+ */
+QImage BezelField::render( const BezelStyle &style, int size ) {
+    if ( size <= 0 )
+        return QImage();
+
+    const QSharedPointer<const BezelField> field( BezelField::shared( style ));
+    const TraceScope trace( "BezelField::render" );
+    QImage image( size, size, QImage::Format_ARGB32_Premultiplied );
+    const qreal half = size / 2.0;
+    const qreal unit = half * BezelField_::Inset;
+    const qreal stroke = style.strokeWidth * size;
+    const qreal bevel = style.bevel * size;
+    const qreal glow = style.glowWidth * size;
+
+    for ( int y = 0; y < size; y++ ) {
+        QRgb *line( reinterpret_cast<QRgb *>( image.scanLine( y )));
+
+        for ( int x = 0; x < size; x++ ) {
+            const qreal u = ( x + 0.5 - half ) / unit;
+            const qreal v = ( y + 0.5 - half ) / unit;
+            const qreal d = field->distance( u, v ) * unit;
+            qreal red = style.fill.redF();
+            qreal green = style.fill.greenF();
+            qreal blue = style.fill.blueF();
+            const qreal alpha = style.fill.alphaF() * qBound( 0.0, 0.5 - d, 1.0 );
+
+            if ( alpha > 0.0 && d < 0.0 ) {
+                // inner glow, strongest at the outline
+                if ( glow > 0.0 && -d < glow ) {
+                    const qreal t = 1.0 + d / glow;
+                    const qreal weight = t * t * style.glow.alphaF();
+
+                    red += ( style.glow.redF() - red ) * weight;
+                    green += ( style.glow.greenF() - green ) * weight;
+                    blue += ( style.glow.blueF() - blue ) * weight;
+                }
+
+                // bevel lit from the top left
+                if ( bevel > 0.0 && -d < bevel ) {
+                    qreal dx, dy;
+                    field->gradient( u, v, &dx, &dy );
+
+                    const qreal length = qSqrt( dx * dx + dy * dy );
+                    if ( length > 0.0 ) {
+                        const qreal shade = -( dx + dy ) / length * M_SQRT1_2 * ( 1.0 + d / bevel ) * style.bevelStrength;
+                        const qreal target = shade > 0.0 ? 1.0 : 0.0;
+
+                        red += ( target - red ) * qAbs( shade );
+                        green += ( target - green ) * qAbs( shade );
+                        blue += ( target - blue ) * qAbs( shade );
+                    }
+                }
+            }
+
+            // stroke centred on the outline (coverage of thin strokes is limited to their width)
+            const qreal coverage = stroke > 0.0 ? qBound( 0.0, stroke / 2.0 - qAbs( d ) + 0.5, qMin( 1.0, stroke )) * style.stroke.alphaF() : 0.0;
+            const qreal a = coverage + alpha * ( 1.0 - coverage );
+            line[x] = qRgba( qRound(( style.stroke.redF() * coverage + red * alpha * ( 1.0 - coverage )) * 255 ),
+                             qRound(( style.stroke.greenF() * coverage + green * alpha * ( 1.0 - coverage )) * 255 ),
+                             qRound(( style.stroke.blueF() * coverage + blue * alpha * ( 1.0 - coverage )) * 255 ),
+                             qRound( a * 255 ));
+        }
+    }
+
+    return image;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QColor>
+#include <QImage>
+#include <QSharedPointer>
+#include <QVector>
+
+/**
+ * @brief The BezelField_ namespace
+ */
+namespace BezelField_ {
+constexpr int Resolution = 512;
+constexpr qreal Extent = 1.25; // field covers [-Extent, Extent]^2, outline at distance 0 on the unit square
+constexpr qreal Inset = 0.9;   // outline half size relative to half the image size
+}
+
+/**
+ * @brief The BezelStyle struct describes a bezel (widths are fractions of the image size)
+ */
+struct BezelStyle {
+    enum class Outlines {
+        NoOutline = -1,
+        RoundedRect,
+        Squircle
+    };
+
+    Outlines outline;
+    qreal radius;       // corner radius (rounded rect) relative to half size
+    qreal exponent;     // superellipse exponent (squircle)
+    QColor fill;
+    QColor stroke;
+    qreal strokeWidth;
+    qreal bevel;
+    qreal bevelStrength;
+    QColor glow;
+    qreal glowWidth;
+    BezelStyle() :
+        outline( Outlines::RoundedRect ),
+        radius( 0.35 ),
+        exponent( 5.0 ),
+        fill( 0x3d, 0x7e, 0xd6 ),
+        stroke( 0x1b, 0x3f, 0x75 ),
+        strokeWidth( 0.02 ),
+        bevel( 0.06 ),
+        bevelStrength( 0.35 ),
+        glow( 255, 255, 255, 96 ),
+        glowWidth( 0.08 ) {}
+    bool operator==( const BezelStyle &other ) const;
+    bool operator!=( const BezelStyle &other ) const { return !( *this == other ); }
+};
+
+/**
+ * @brief The BezelField class is a sampled signed distance field of a bezel outline
+ *
+ * Fields depend only on the outline (not on colours, widths or output size)
+ * and are shared between all bezels and renders using the same outline.
+ * Distances are negative inside and expressed in outline half sizes, so a
+ * render of any size scales them to pixels and derives coverage, stroke,
+ * bevel and glow analytically in a single pass over the output.
+ */
+class BezelField final {
+public:
+    static QSharedPointer<const BezelField> shared( const BezelStyle &style );
+    static QImage render( const BezelStyle &style, int size );
+    qreal distance( qreal x, qreal y ) const;
+    void gradient( qreal x, qreal y, qreal *dx, qreal *dy ) const;
+
+private:
+    explicit BezelField( const BezelStyle &style );
+    static qreal evaluate( const BezelStyle &style, qreal x, qreal y );
+    QVector<float> values;
+};
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "bezellayer.h"
+#include "memoryusage.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
+
+/**
+ * @brief BezelItem::BezelItem
+ * @param rect
+ * @param parent
+ */
+BezelItem::BezelItem( const QRectF &rect, QGraphicsItem *parent ) : QGraphicsItem( parent ), rect( rect ), cache( BezelLayer_::CacheSize ) {}
+
+/**
+ * @brief BezelItem::paint
+ * @param painter
+ * @param option
+ * @param widget
+ */
+void BezelItem::paint( QPainter *painter, const QStyleOptionGraphicsItem *, QWidget * ) {
+    const qreal detail = QStyleOptionGraphicsItem::levelOfDetailFromTransform( painter->worldTransform());
+    const int size = qBound( 1, qCeil( this->rect.width() * detail ), BezelLayer_::MaximumSize );
+
+    if ( !this->cache.contains( size )) {
+        QImage *image( new QImage( BezelField::render( this->style(), size )));
+        this->cache.insert( size, image, static_cast<int>( qMin( MemoryUsage::imageBytes( *image ), static_cast<qint64>( BezelLayer_::CacheSize ))));
+    }
+
+    const QImage *image( this->cache.object( size ));
+    if ( image != nullptr )
+        painter->drawImage( this->rect, *image );
+}
+
+/**
+ * @brief BezelItem::setStyle
+ * @param style
+ */
+void BezelItem::setStyle( const BezelStyle &style ) {
+    if ( this->m_style == style )
+        return;
+
+    this->m_style = style;
+    this->cache.clear();
+    this->update();
+}
+
+/**
+ * @brief BezelLayer::BezelLayer
+ * @param scene
+ * @param outline
+ */
+BezelLayer::BezelLayer( QGraphicsScene *scene, BezelStyle::Outlines outline ) :
+    DesignerLayer( scene ),
+    bezelItem( nullptr )
+{
+    BezelStyle style;
+
+    if ( this->scene() == nullptr )
+        return;
+
+    DesignerLayer::setType( DesignerLayer::Types::Bezel );
+    DesignerLayer::setName( outline == BezelStyle::Outlines::Squircle ? this->tr( "Squircle bezel" ) : this->tr( "Rounded bezel" ));
+
+    style.outline = outline;
+    this->bezelItem = new BezelItem( this->scene()->sceneRect());
+    this->bezelItem->setStyle( style );
+    this->scene()->addItem( this->bezelItem );
+}
+
+/**
+ * @brief BezelLayer::item
+ * @return
+ */
+QGraphicsItem *BezelLayer::item() {
+    return this->bezelItem;
+}
+
+/**
+ * @brief BezelLayer::pixelBytes
+ * @return bytes held by rasterized sizes
+ */
+qint64 BezelLayer::pixelBytes() const {
+    return this->bezelItem == nullptr ? 0 : this->bezelItem->cachedBytes();
+}
+
+/**
+ * @brief BezelLayer::style
+ * @return
+ */
+const BezelStyle &BezelLayer::style() const {
+    static const BezelStyle empty;
+    return this->bezelItem == nullptr ? empty : this->bezelItem->style();
+}
+
+/**
+ * @brief BezelLayer::setStyle
+ * @param style
+ */
+void BezelLayer::setStyle( const BezelStyle &style ) {
+    if ( this->bezelItem != nullptr )
+        this->bezelItem->setStyle( style );
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include "designerlayer.h"
+#include "bezelfield.h"
+#include <QCache>
+#include <QGraphicsItem>
+
+/**
+ * @brief The BezelLayer_ namespace
+ */
+namespace BezelLayer_ {
+constexpr int CacheSize = 16 * 1024 * 1024; // bytes of rasterized sizes kept per bezel
+constexpr int MaximumSize = 4096;
+}
+
+/**
+ * @brief The BezelItem class paints a bezel rasterized at the device resolution
+ *
+ * Each distinct on-screen or export size is rendered once from the shared
+ * distance field and kept until the style changes.
+ */
+class BezelItem final : public QGraphicsItem {
+public:
+    explicit BezelItem( const QRectF &rect, QGraphicsItem *parent = nullptr );
+    QRectF boundingRect() const override { return this->rect; }
+    void paint( QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr ) override;
+    const BezelStyle &style() const { return this->m_style; }
+    void setStyle( const BezelStyle &style );
+    qint64 cachedBytes() const { return this->cache.totalCost(); }
+
+private:
+    QRectF rect;
+    BezelStyle m_style;
+    QCache<int, QImage> cache;
+};
+
+/**
+ * @brief The BezelLayer class
+ */
+class BezelLayer final : public DesignerLayer {
+    Q_OBJECT
+    friend class Designer;
+
+public:
+    BezelLayer( QGraphicsScene *scene = nullptr, BezelStyle::Outlines outline = BezelStyle::Outlines::RoundedRect );
+    QGraphicsItem *item() override;
+    qint64 pixelBytes() const override;
+    const BezelStyle &style() const;
+    void setStyle( const BezelStyle &style );
+
+private:
+    BezelItem *bezelItem;
+};
@@ -4,66 +4,18 @@
 #
 #-------------------------------------------------
 
-QT       += core gui xml
-win32:RC_FILE = icon.rc
-
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
-
-TARGET = BurningIcon
-TEMPLATE = app
-
-# The following define makes your compiler emit warnings if you use
-# any feature of Qt which as been marked as deprecated (the exact warnings
-# depend on your compiler). Please consult the documentation of the
-# deprecated API in order to know how to port your code away from it.
-DEFINES += QT_DEPRECATED_WARNINGS
-
-# You can also make your code fail to compile if you use deprecated APIs.
-# In order to do so, uncomment the following line.
-# You can also select to disable deprecated APIs only up to a certain version of Qt.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
-
-
-SOURCES += \
-        main.cpp \
-        mainwindow.cpp \
-    iconwriter.cpp \
-    layermodel.cpp \
-    xmltools.cpp \
-    variable.cpp \
-    settings.cpp \
-    textlayer.cpp \
-    designer.cpp \
-    imagelayer.cpp \
-    designermodel.cpp \
-    shapelayer.cpp
-
-HEADERS += \
-        mainwindow.h \
-    iconwriter.h \
-    pixmaplabel.h \
-    layermodel.h \
-    layer.h \
-    xmltools.h \
-    main.h \
-    variable.h \
-    variableentry.h \
-    widget.h \
-    settings.h \
-    slider.h \
-    textlayer.h \
-    designer.h \
-    designerlayer.h \
-    imagelayer.h \
-    designermodel.h \
-    shapelayer.h
-
-FORMS += \
-        mainwindow.ui \
-    settings.ui \
-    designer.ui
-
-DISTFILES +=
-
-RESOURCES += \
-    resources.qrc
+TEMPLATE = subdirs
+
+# reentrant core (sources, layer sets, readers and writers), GUI, daemon client and benchmarks
+SUBDIRS = \
+    lib \
+    app \
+    client \
+    tests
+
+lib.file = libburningicon.pro
+app.file = app.pro
+app.depends = lib
+client.subdir = client
+tests.subdir = tests
+tests.depends = lib
@@ -0,0 +1,22 @@
+#-------------------------------------------------
+#
+# Thin client for the BurningIcon conversion daemon
+#
+#-------------------------------------------------
+
+QT       = core network
+CONFIG  += console
+CONFIG  -= app_bundle
+
+TARGET = burningicon-client
+TEMPLATE = app
+INCLUDEPATH += ..
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+        main.cpp
+
+HEADERS += \
+    ../daemonprotocol.h \
+    ../standardoutput.h
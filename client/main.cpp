@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "daemonprotocol.h"
+#include "standardoutput.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QLocalSocket>
+#include <QSaveFile>
+
+/**
+ * @brief The Client_ namespace
+ */
+namespace Client_ {
+constexpr int ConnectTimeout = 1000;
+constexpr int ResponseTimeout = 60000;
+constexpr quint32 RequestId = 1;
+}
+
+/**
+ * @brief main
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main( int argc, char *argv[] ) {
+    QCoreApplication app( argc, argv );
+    QCommandLineParser parser;
+    QCommandLineOption outputOption( QStringList() << "o" << "output", "Write icon to <file> ('-' for stdout).", "file", "-" );
+    QCommandLineOption socketOption( "socket", "Local socket <name> of the daemon.", "name", DaemonProtocol::ServerName );
+    QCommandLineOption templateOption( "template", "Layer template <index> (daemon default if omitted).", "index", "-1" );
+    QCommandLineOption formatOption( "format", "Icon <format> (ico or icns, derived from output if omitted).", "format" );
+
+    parser.setApplicationDescription( "BurningIcon daemon client" );
+    parser.addHelpOption();
+    parser.addPositionalArgument( "image", "Source image (png, jpg, bmp or svg)." );
+    parser.addOption( outputOption );
+    parser.addOption( socketOption );
+    parser.addOption( templateOption );
+    parser.addOption( formatOption );
+    parser.process( app );
+
+    if ( parser.positionalArguments().count() != 1 ) {
+        qCritical( "expected exactly one source image" );
+        return 1;
+    }
+
+    // read source
+    QFile input( parser.positionalArguments().first());
+    if ( !input.open( QIODevice::ReadOnly )) {
+        qCritical( "could not read \"%s\"", qPrintable( input.fileName()));
+        return 1;
+    }
+
+    const QString output( parser.value( outputOption ));
+    QString format( parser.value( formatOption ));
+    if ( format.isEmpty())
+        format = output.endsWith( ".icns", Qt::CaseInsensitive ) ? "icns" : "ico";
+
+    // build request
+    QByteArray request;
+    QDataStream out( &request, QIODevice::WriteOnly );
+    out.setVersion( DaemonProtocol::StreamVersion );
+    out << DaemonProtocol::Version << Client_::RequestId << format << static_cast<qint32>( parser.value( templateOption ).toInt()) << QList<int>() << input.readAll();
+    input.close();
+
+    // send and wait for a single response
+    QLocalSocket socket;
+    socket.connectToServer( parser.value( socketOption ));
+    if ( !socket.waitForConnected( Client_::ConnectTimeout )) {
+        qCritical( "could not connect to daemon: %s", qPrintable( socket.errorString()));
+        return 1;
+    }
+    socket.write( DaemonProtocol::frame( request ));
+
+    QByteArray buffer, payload;
+    bool error = false;
+    while ( !DaemonProtocol::takeFrame( buffer, payload, &error ) && !error ) {
+        if ( !socket.waitForReadyRead( Client_::ResponseTimeout )) {
+            qCritical( "no response from daemon: %s", qPrintable( socket.errorString()));
+            return 1;
+        }
+        buffer.append( socket.readAll());
+    }
+
+    if ( error ) {
+        qCritical( "malformed response" );
+        return 1;
+    }
+
+    // parse response
+    QDataStream in( payload );
+    quint32 id;
+    bool ok;
+    QString message;
+    QByteArray icon;
+    in.setVersion( DaemonProtocol::StreamVersion );
+    in >> id >> ok >> message >> icon;
+
+    if ( in.status() != QDataStream::Ok || id != Client_::RequestId || !ok ) {
+        qCritical( "conversion failed: %s", qPrintable( message ));
+        return 1;
+    }
+
+    // write output
+    if ( !QString::compare( output, "-" )) {
+        QFile file;
+
+        if ( !StandardOutput::open( file ) || file.write( icon ) != icon.size())
+            return 1;
+
+        return 0;
+    }
+
+    QSaveFile file( output );
+    if ( !file.open( QIODevice::WriteOnly ) || file.write( icon ) != icon.size() || !file.commit()) {
+        qCritical( "could not write icon \"%s\"", qPrintable( output ));
+        return 1;
+    }
+
+    return 0;
+}
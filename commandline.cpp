@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "commandline.h"
+#include "atlas.h"
+#include "daemon.h"
+#include "daemonprotocol.h"
+#include "iconsource.h"
+#include "iconwriter.h"
+#include "layerset.h"
+#include "main.h"
+#include "memoryusage.h"
+#include "multiexport.h"
+#include "trace.h"
+#include "mainwindow.h"
+#include "outputcache.h"
+#include "settings.h"
+#include "standardoutput.h"
+#include "variable.h"
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <cstdio>
+
+/**
+ * @brief CommandLine::CommandLine
+ * @param parent
+ */
+CommandLine::CommandLine( QObject *parent ) : QObject( parent ),
+    outputOption( QStringList() << "o" << "output", CommandLine::tr( "Write icon to <file> without opening the main window ('-' for stdout)." ), CommandLine::tr( "file" )),
+    cacheOption( "cache-dir", CommandLine::tr( "Store converted icons in <directory>." ), CommandLine::tr( "directory" )),
+    noCacheOption( "no-cache", CommandLine::tr( "Do not use the output cache." )),
+    daemonOption( "daemon", CommandLine::tr( "Serve conversions over a local socket until terminated." )),
+    socketOption( "socket", CommandLine::tr( "Local socket <name> used by the daemon." ), CommandLine::tr( "name" ), DaemonProtocol::ServerName ),
+    memoryOption( "memory-report", CommandLine::tr( "Write pixel, transient and per-stage allocation statistics as JSON to <file> ('-' for stderr)." ), CommandLine::tr( "file" )),
+    reportOption( "report", CommandLine::tr( "Write per-entry size, compression ratio and encode time as JSON to <file> ('-' for stderr)." ), CommandLine::tr( "file" )),
+    targetsOption( "targets", CommandLine::tr( "Write comma separated <targets> (ico, icns, android, ios, hicolor, favicon) into the -o directory from one shared set of resampled images." ), CommandLine::tr( "targets" )),
+    atlasOption( "atlas", CommandLine::tr( "Pack all layers of the given images into a single power-of-two png texture -o, with .json and .bin rectangle indexes." )),
+    paddingOption( "padding", CommandLine::tr( "Atlas padding in <pixels> (default 1)." ), CommandLine::tr( "pixels" ), "1" ),
+    extrudeOption( "extrude", CommandLine::tr( "Fill atlas padding with edge pixels." )) {
+    this->parser.setApplicationDescription( Ui::AppName );
+    this->parser.addHelpOption();
+    this->parser.addPositionalArgument( "image", CommandLine::tr( "Source image (png, jpg, bmp or svg)." ));
+    this->parser.addOption( this->outputOption );
+    this->parser.addOption( this->cacheOption );
+    this->parser.addOption( this->noCacheOption );
+    this->parser.addOption( this->daemonOption );
+    this->parser.addOption( this->socketOption );
+    this->parser.addOption( this->memoryOption );
+    this->parser.addOption( this->reportOption );
+    this->parser.addOption( this->targetsOption );
+    this->parser.addOption( this->atlasOption );
+    this->parser.addOption( this->paddingOption );
+    this->parser.addOption( this->extrudeOption );
+}
+
+/**
+ * @brief CommandLine::isHeadless checks arguments before an application object exists
+ * @param arguments
+ * @return true if no window is needed (conversion, daemon or help)
+ *
+ * Errors are reported later by parse, once the application is constructed.
+ */
+bool CommandLine::isHeadless( const QStringList &arguments ) {
+    if ( !this->parser.parse( arguments ))
+        return false;
+
+    return this->parser.isSet( this->outputOption ) || this->parser.isSet( this->daemonOption ) || this->parser.isSet( "help" );
+}
+
+/**
+ * @brief CommandLine::parse
+ * @param arguments
+ * @return true if headless conversion or daemon mode was requested
+ */
+bool CommandLine::parse( const QStringList &arguments ) {
+    this->parser.process( arguments );
+
+    // stage totals are needed for memory reports
+    if ( this->parser.isSet( this->memoryOption ))
+        Trace::instance()->setEnabled();
+
+    return this->parser.isSet( this->outputOption ) || this->parser.isSet( this->daemonOption );
+}
+
+/**
+ * @brief CommandLine::parameters serializes everything that affects output
+ * @return
+ */
+QByteArray CommandLine::parameters() const {
+    QByteArray bytes;
+    QDataStream out( &bytes, QIODevice::WriteOnly );
+    const bool macOS = Settings_::MacOS.value();
+
+    out << macOS
+        << Settings_::LegacyICNS.value()
+        << Settings_::Compress.value()
+        << Settings_::CompressThreshold.value()
+        << static_cast<qint32>( Ui::MaximumScale );
+
+    if ( !macOS )
+        out << Settings::layerTemplate( static_cast<Settings::Templates>( Settings_::Template.value())).scales;
+
+    return bytes;
+}
+
+/**
+ * @brief CommandLine::convert decodes, resamples and writes an icon
+ * @param fileName
+ * @param output file name or '-' for stdout
+ * @return
+ */
+bool CommandLine::convert( const QString &fileName, const QString &output ) const {
+    const IconSource source( IconSource::fromFile( fileName ));
+    if ( !source.isValid()) {
+        qCCritical( CommandLine_::Debug ) << CommandLine::tr( "invalid image \"%1\"" ).arg( fileName );
+        return false;
+    }
+
+    const LayerSet layers( source, Settings::layerSetOptions());
+    const IconWriter writer( Settings::writerOptions());
+    ExportReport report;
+    bool ok;
+
+    MemoryUsage::instance()->resetPeak();
+
+    if ( !QString::compare( output, "-" )) {
+        QFile file;
+
+        ok = StandardOutput::open( file ) && writer.write( &file, layers.layers(), &report );
+        file.close();
+    } else {
+        // replace the output only once fully written
+        QSaveFile file( output );
+
+        ok = file.open( QIODevice::WriteOnly ) && writer.write( &file, layers.layers(), &report ) && file.commit();
+    }
+
+    if ( !ok )
+        qCCritical( CommandLine_::Debug ) << CommandLine::tr( "could not write icon \"%1\"" ).arg( output );
+
+    if ( ok )
+        this->writeJson( this->parser.value( this->reportOption ), report.toJson());
+
+    this->writeJson( this->parser.value( this->memoryOption ), MemoryUsage::report( layers.layers(), source.image()));
+    return ok;
+}
+
+/**
+ * @brief CommandLine::exportTargets writes several platform targets at once
+ * @param fileName
+ * @param directory
+ * @return
+ */
+bool CommandLine::exportTargets( const QString &fileName, const QString &directory ) const {
+    QList<ExportTarget> targets;
+
+    foreach ( const QString &name, this->parser.value( this->targetsOption ).split( "," )) {
+        const ExportTarget target( MultiExport::target( name ));
+
+        if ( name.trimmed().isEmpty())
+            continue;
+
+        if ( target == ExportTarget::NoTarget ) {
+            qCCritical( CommandLine_::Debug ) << CommandLine::tr( "unknown target \"%1\"" ).arg( name );
+            return false;
+        }
+
+        if ( !targets.contains( target ))
+            targets << target;
+    }
+
+    if ( !QString::compare( directory, "-" )) {
+        qCCritical( CommandLine_::Debug ) << CommandLine::tr( "targets need an output directory" );
+        return false;
+    }
+
+    const IconSource source( IconSource::fromFile( fileName ));
+    if ( !source.isValid()) {
+        qCCritical( CommandLine_::Debug ) << CommandLine::tr( "invalid image \"%1\"" ).arg( fileName );
+        return false;
+    }
+
+    // ico entries follow the current template (or Windows 7 for macOS)
+    const QSharedPointer<const VariableSnapshot> settings( Variable::instance()->snapshot());
+    QList<int> scales( Settings::layerTemplate( static_cast<Settings::Templates>( Settings_::Template.value( *settings )), *settings ).scales );
+    if ( scales.isEmpty())
+        scales = Settings::layerTemplate( Settings::Windows7, *settings ).scales;
+
+    const MultiExport exporter( MultiExportOptions( targets, QFileInfo( fileName ).completeBaseName(), scales,
+                                                    Settings_::Compress.value( *settings ),
+                                                    Settings_::CompressThreshold.value( *settings ),
+                                                    Settings_::LegacyICNS.value( *settings )));
+    QStringList written;
+
+    MemoryUsage::instance()->resetPeak();
+    const bool ok = exporter.write( source, directory, &written );
+    qCInfo( CommandLine_::Debug ) << CommandLine::tr( "%1 files written from %2 resampled sizes" ).arg( written.count()).arg( exporter.scales().count());
+
+    this->writeJson( this->parser.value( this->memoryOption ), MemoryUsage::report( QList<Layer*>(), source.image()));
+    return ok;
+}
+
+/**
+ * @brief CommandLine::exportAtlas packs layers of one or more images into a texture atlas
+ * @param files
+ * @param output
+ * @return
+ */
+bool CommandLine::exportAtlas( const QStringList &files, const QString &output ) const {
+    Atlas atlas( AtlasOptions( qMax( 0, this->parser.value( this->paddingOption ).toInt()), this->parser.isSet( this->extrudeOption )));
+    const LayerSetOptions options( Settings::layerSetOptions());
+
+    if ( files.isEmpty() || !QString::compare( output, "-" )) {
+        qCCritical( CommandLine_::Debug ) << CommandLine::tr( "atlas needs source images and an output file" );
+        return false;
+    }
+
+    foreach ( const QString &fileName, files ) {
+        const IconSource source( IconSource::fromFile( fileName ));
+        if ( !source.isValid()) {
+            qCCritical( CommandLine_::Debug ) << CommandLine::tr( "invalid image \"%1\"" ).arg( fileName );
+            return false;
+        }
+
+        // images are shared with the atlas, layers can go
+        const LayerSet layers( source, options );
+        atlas.add( layers.layers(), QFileInfo( fileName ).completeBaseName());
+    }
+
+    if ( !atlas.pack() || !atlas.write( output )) {
+        qCCritical( CommandLine_::Debug ) << CommandLine::tr( "could not write atlas \"%1\"" ).arg( output );
+        return false;
+    }
+
+    qCInfo( CommandLine_::Debug ) << CommandLine::tr( "%1 entries packed into %2x%3" ).arg( atlas.entries().count()).arg( atlas.image().width()).arg( atlas.image().height());
+    return true;
+}
+
+/**
+ * @brief CommandLine::writeJson writes a report if requested
+ * @param output file name, '-' for stderr or empty to skip
+ * @param object
+ */
+void CommandLine::writeJson( const QString &output, const QJsonObject &object ) const {
+    const QByteArray json( QJsonDocument( object ).toJson());
+
+    if ( output.isEmpty())
+        return;
+
+    if ( !QString::compare( output, "-" )) {
+        QFile file;
+
+        if ( file.open( stderr, QIODevice::WriteOnly ))
+            file.write( json );
+        return;
+    }
+
+    QSaveFile file( output );
+    if ( !file.open( QIODevice::WriteOnly ) || file.write( json ) != json.size() || !file.commit())
+        qCWarning( CommandLine_::Debug ) << CommandLine::tr( "could not write report \"%1\"" ).arg( output );
+}
+
+/**
+ * @brief CommandLine::exec
+ * @return process exit code
+ */
+int CommandLine::exec() {
+    const QString output( this->parser.value( this->outputOption ));
+    const QStringList arguments( this->parser.positionalArguments());
+
+    // keep serving until terminated
+    if ( this->parser.isSet( this->daemonOption )) {
+        Daemon daemon;
+
+        if ( !daemon.listen( this->parser.value( this->socketOption )))
+            return 1;
+
+        return QCoreApplication::exec();
+    }
+
+    if ( this->parser.isSet( this->atlasOption ))
+        return this->exportAtlas( arguments, output ) ? 0 : 1;
+
+    if ( arguments.count() != 1 ) {
+        qCCritical( CommandLine_::Debug ) << CommandLine::tr( "expected exactly one source image" );
+        return 1;
+    }
+
+    if ( this->parser.isSet( this->targetsOption ))
+        return this->exportTargets( arguments.first(), output ) ? 0 : 1;
+
+    // output format follows the extension, stdout uses stored settings
+    if ( output.endsWith( ".icns", Qt::CaseInsensitive ))
+        Settings_::MacOS.setValue( true );
+    else if ( output.endsWith( ".ico", Qt::CaseInsensitive ))
+        Settings_::MacOS.setValue( false );
+
+    if ( this->parser.isSet( this->noCacheOption ))
+        return this->convert( arguments.first(), output ) ? 0 : 1;
+
+    // hash input bytes together with settings
+    QFile input( arguments.first());
+    if ( !input.open( QIODevice::ReadOnly )) {
+        qCCritical( CommandLine_::Debug ) << CommandLine::tr( "could not read \"%1\"" ).arg( arguments.first());
+        return 1;
+    }
+
+    // cache lives in the configuration directory unless given
+    QString cacheDir( this->parser.value( this->cacheOption ));
+    if ( cacheDir.isEmpty())
+        cacheDir = QDir::homePath() + "/" + Main::Path + "/" + OutputCache_::CacheDir;
+
+    OutputCache cache( cacheDir );
+    if ( !cache.isValid()) {
+        qCWarning( CommandLine_::Debug ) << CommandLine::tr( "output cache unavailable" );
+        return this->convert( arguments.first(), output ) ? 0 : 1;
+    }
+
+    const QString cached( cache.fileName( input.readAll(), this->parameters(), Settings_::MacOS.value() ? "icns" : "ico" ));
+    const bool hit = QFile::exists( cached );
+    input.close();
+
+    // encode into the cache on miss
+    if ( !hit && !this->convert( arguments.first(), cached ))
+        return 1;
+
+    cache.record( hit );
+    if ( hit ) {
+        QJsonObject report;
+
+        // nothing was encoded, only the delivered size is known
+        report["cached"] = true;
+        report["bytes"] = static_cast<double>( QFileInfo( cached ).size());
+        this->writeJson( this->parser.value( this->reportOption ), report );
+        this->writeJson( this->parser.value( this->memoryOption ), MemoryUsage::report( QList<Layer*>()));
+    }
+    qCInfo( CommandLine_::Debug ) << CommandLine::tr( "cache %1 (%2 hits, %3 misses)" ).arg( hit ? "hit" : "miss" ).arg( cache.hits()).arg( cache.misses());
+
+    if ( !cache.deliver( cached, output )) {
+        qCCritical( CommandLine_::Debug ) << CommandLine::tr( "could not write icon \"%1\"" ).arg( output );
+        return 1;
+    }
+
+    return 0;
+}
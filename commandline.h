@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QStringList>
+
+/**
+ * @brief The CommandLine_ namespace
+ */
+namespace CommandLine_ {
+const static QLoggingCategory Debug( "cli" );
+}
+
+/**
+ * @brief The CommandLine class handles headless conversion
+ */
+class CommandLine final : public QObject {
+    Q_OBJECT
+    Q_DISABLE_COPY( CommandLine )
+
+public:
+    explicit CommandLine( QObject *parent = nullptr );
+    ~CommandLine() = default;
+    bool isHeadless( const QStringList &arguments );
+    bool parse( const QStringList &arguments );
+    int exec();
+
+private:
+    QByteArray parameters() const;
+    bool convert( const QString &fileName, const QString &output ) const;
+    bool exportTargets( const QString &fileName, const QString &directory ) const;
+    bool exportAtlas( const QStringList &files, const QString &output ) const;
+    void writeJson( const QString &output, const QJsonObject &object ) const;
+    QCommandLineParser parser;
+    QCommandLineOption outputOption;
+    QCommandLineOption cacheOption;
+    QCommandLineOption noCacheOption;
+    QCommandLineOption daemonOption;
+    QCommandLineOption socketOption;
+    QCommandLineOption memoryOption;
+    QCommandLineOption reportOption;
+    QCommandLineOption targetsOption;
+    QCommandLineOption atlasOption;
+    QCommandLineOption paddingOption;
+    QCommandLineOption extrudeOption;
+};
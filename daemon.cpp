@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "daemon.h"
+#include "daemonprotocol.h"
+#include "iconwriter.h"
+#include "layerset.h"
+#include "settings.h"
+#include "variable.h"
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QFutureWatcher>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QtConcurrent>
+
+/**
+ * @brief Daemon::Daemon
+ * @param parent
+ *
+ * Settings are snapshotted here, on the main thread; workers read the
+ * immutable snapshot and never touch the live Variable list.
+ */
+Daemon::Daemon( QObject *parent ) : QObject( parent ), server( new QLocalServer( this )), settings( Variable::instance()->snapshot()) {
+    this->sources.setMaxCost( Daemon_::SourceCacheKiB );
+
+    this->connect( this->server, &QLocalServer::newConnection, this, &Daemon::newConnection );
+}
+
+/**
+ * @brief Daemon::~Daemon
+ */
+Daemon::~Daemon() {
+    QThreadPool::globalInstance()->waitForDone();
+    this->server->close();
+}
+
+/**
+ * @brief Daemon::listen
+ * @param name
+ * @return
+ */
+bool Daemon::listen( const QString &name ) {
+    // never take over the socket of a running instance
+    QLocalSocket probe;
+    probe.connectToServer( name );
+    if ( probe.waitForConnected( Daemon_::ProbeTimeout )) {
+        probe.abort();
+        qCCritical( Daemon_::Debug ) << this->tr( "a daemon is already listening on \"%1\"" ).arg( name );
+        return false;
+    }
+
+    // nothing answered, remove stale socket of a crashed instance
+    QLocalServer::removeServer( name );
+
+    if ( !this->server->listen( name )) {
+        qCCritical( Daemon_::Debug ) << this->tr( "could not listen on \"%1\": %2" ).arg( name ).arg( this->server->errorString());
+        return false;
+    }
+
+    qCInfo( Daemon_::Debug ) << this->tr( "listening on \"%1\"" ).arg( this->server->fullServerName());
+    return true;
+}
+
+/**
+ * @brief Daemon::newConnection
+ */
+void Daemon::newConnection() {
+    while ( this->server->hasPendingConnections()) {
+        QLocalSocket *socket( this->server->nextPendingConnection());
+
+        this->buffers[socket] = QByteArray();
+        this->connect( socket, &QLocalSocket::readyRead, this, &Daemon::readRequest );
+        this->connect( socket, &QLocalSocket::disconnected, [ this, socket ]() {
+            this->buffers.remove( socket );
+            socket->deleteLater();
+        } );
+    }
+}
+
+/**
+ * @brief Daemon::readRequest dispatches complete requests to worker threads
+ */
+void Daemon::readRequest() {
+    QLocalSocket *socket( qobject_cast<QLocalSocket*>( this->sender()));
+    QByteArray request;
+    bool error;
+
+    if ( socket == nullptr || !this->buffers.contains( socket ))
+        return;
+
+    QByteArray &buffer = this->buffers[socket];
+    buffer.append( socket->readAll());
+
+    while ( DaemonProtocol::takeFrame( buffer, request, &error )) {
+        QPointer<QLocalSocket> client( socket );
+        QFutureWatcher<QByteArray> *watcher( new QFutureWatcher<QByteArray>( this ));
+
+        // reply on the main thread once encoded (pipelined requests run
+        // concurrently, so replies carry the request id)
+        this->connect( watcher, &QFutureWatcher<QByteArray>::finished, [ watcher, client ]() {
+            if ( !client.isNull())
+                client->write( DaemonProtocol::frame( watcher->result()));
+
+            watcher->deleteLater();
+        } );
+        watcher->setFuture( QtConcurrent::run( [ this, request ]() { return this->process( request ); } ));
+    }
+
+    if ( error )
+        socket->abort();
+}
+
+/**
+ * @brief Daemon::source returns a decoded (and fitted) source image
+ * @param bytes
+ * @return
+ *
+ * Decoded sources are kept in a cache, so repeated requests with the
+ * same image skip decoding entirely.
+ */
+IconSource Daemon::source( const QByteArray &bytes ) {
+    const QByteArray key( QCryptographicHash::hash( bytes, QCryptographicHash::Sha1 ));
+
+    {
+        QMutexLocker locker( &this->mutex );
+        if ( this->sources.contains( key ))
+            return *this->sources.object( key );
+    }
+
+    const IconSource source( IconSource::fromData( bytes ));
+    if ( !source.isValid())
+        return source;
+
+    QMutexLocker locker( &this->mutex );
+    this->sources.insert( key, new IconSource( source ), qMax( 1, static_cast<int>( static_cast<qint64>( source.image().bytesPerLine()) * source.image().height() / 1024 )));
+
+    return source;
+}
+
+/**
+ * @brief Daemon::process encodes a single request (runs on a worker thread)
+ * @param request
+ * @return response payload
+ */
+QByteArray Daemon::process( const QByteArray &request ) {
+    QDataStream in( request );
+    QByteArray response;
+    QDataStream out( &response, QIODevice::WriteOnly );
+    qint32 version, templateIndex;
+    quint32 id = 0;
+    QString format;
+    QList<int> scales;
+    QByteArray bytes;
+
+    in.setVersion( DaemonProtocol::StreamVersion );
+    out.setVersion( DaemonProtocol::StreamVersion );
+    in >> version;
+    if ( in.status() == QDataStream::Ok && version == DaemonProtocol::Version )
+        in >> id >> format >> templateIndex >> scales >> bytes;
+
+    // responses may complete out of order, the id matches them to requests
+    out << id;
+
+    // validate request
+    if ( in.status() != QDataStream::Ok || version != DaemonProtocol::Version ) {
+        out << false << this->tr( "malformed request" ) << QByteArray();
+        return response;
+    }
+
+    const IconSource source( this->source( bytes ));
+    if ( !source.isValid()) {
+        out << false << this->tr( "invalid image" ) << QByteArray();
+        return response;
+    }
+
+    // build layers
+    const bool macOS = !QString::compare( format, "icns", Qt::CaseInsensitive );
+    LayerSetOptions options( Settings::layerSetOptions( *this->settings ));
+    options.macOS = macOS;
+    if ( !scales.isEmpty())
+        options.scales = scales;
+    else if ( templateIndex >= 0 )
+        options.scales = Settings::layerTemplate( static_cast<Settings::Templates>( templateIndex ), *this->settings ).scales;
+
+    const LayerSet layers( source, options );
+
+    // encode
+    QByteArray icon;
+    QBuffer buffer( &icon );
+    buffer.open( QIODevice::WriteOnly );
+    const bool ok = !layers.isEmpty() && IconWriter( WriterOptions( macOS, Settings_::LegacyICNS.value( *this->settings ))).write( &buffer, layers.layers());
+    buffer.close();
+
+    out << ok << ( ok ? QString() : this->tr( "could not encode icon" )) << icon;
+    return response;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QCache>
+#include <QHash>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QObject>
+#include "iconsource.h"
+#include "variable.h"
+
+/**
+ * @brief The Daemon_ namespace
+ */
+namespace Daemon_ {
+const static QLoggingCategory Debug( "daemon" );
+constexpr int SourceCacheKiB = 256 * 1024;
+constexpr int ProbeTimeout = 500;
+}
+
+//
+// classes
+//
+class QLocalServer;
+class QLocalSocket;
+
+/**
+ * @brief The Daemon class serves icon conversions over a local socket
+ */
+class Daemon final : public QObject {
+    Q_OBJECT
+    Q_DISABLE_COPY( Daemon )
+
+public:
+    explicit Daemon( QObject *parent = nullptr );
+    ~Daemon();
+    bool listen( const QString &name );
+
+private slots:
+    void newConnection();
+    void readRequest();
+
+private:
+    QByteArray process( const QByteArray &request );
+    IconSource source( const QByteArray &bytes );
+    QLocalServer *server;
+    QHash<QLocalSocket*, QByteArray> buffers;
+    QSharedPointer<const VariableSnapshot> settings;
+    QCache<QByteArray, IconSource> sources;
+    QMutex mutex;
+};
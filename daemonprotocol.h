@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QByteArray>
+#include <QDataStream>
+#include <QIODevice>
+#include <QList>
+#include <QString>
+#include <QtEndian>
+
+/**
+ * @brief The DaemonProtocol namespace (shared by daemon and client)
+ *
+ * Every message is a 32-bit big-endian length followed by a QDataStream
+ * payload.
+ *
+ * request:  qint32 version, quint32 id (chosen by the client),
+ *           QString format ("ico" or "icns"), qint32 template (-1 for
+ *           daemon default), QList<int> scales (overrides template if not
+ *           empty), QByteArray image
+ * response: quint32 id (of the request, 0 if unreadable), bool ok,
+ *           QString error, QByteArray icon
+ *
+ * Requests pipelined on one connection are processed concurrently and
+ * answered as they complete, possibly out of order.
+ */
+namespace DaemonProtocol {
+#ifdef Q_CC_MSVC
+static constexpr const char *ServerName = "burningicon";
+#else
+static constexpr const char __attribute__((unused)) *ServerName = "burningicon";
+#endif
+constexpr qint32 Version = 2;
+constexpr QDataStream::Version StreamVersion = QDataStream::Qt_5_6;
+constexpr quint32 MaximumMessageSize = 256 * 1024 * 1024;
+
+/**
+ * @brief frame prefixes payload with its length
+ * @param payload
+ * @return
+ */
+inline static QByteArray frame( const QByteArray &payload ) {
+    QByteArray bytes( 4, 0 );
+    qToBigEndian<quint32>( static_cast<quint32>( payload.size()), reinterpret_cast<uchar*>( bytes.data()));
+    return bytes + payload;
+}
+
+/**
+ * @brief takeFrame extracts a complete message from buffered input
+ * @param buffer accumulated input, consumed on success
+ * @param payload
+ * @param error set on oversized messages
+ * @return true if a complete message was extracted
+ */
+inline static bool takeFrame( QByteArray &buffer, QByteArray &payload, bool *error = nullptr ) {
+    if ( error != nullptr )
+        *error = false;
+
+    if ( buffer.size() < 4 )
+        return false;
+
+    const quint32 size = qFromBigEndian<quint32>( reinterpret_cast<const uchar*>( buffer.constData()));
+    if ( size > MaximumMessageSize ) {
+        if ( error != nullptr )
+            *error = true;
+        return false;
+    }
+
+    if ( static_cast<quint32>( buffer.size()) < size + 4 )
+        return false;
+
+    payload = buffer.mid( 4, static_cast<int>( size ));
+    buffer.remove( 0, static_cast<int>( size ) + 4 );
+    return true;
+}
+}
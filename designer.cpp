@@ -31,18 +31,35 @@
 #include "designermodel.h"
 #include "shapelayer.h"
 #include "textlayer.h"
+#include "bezellayer.h"
 #include <QDebug>
 #include "imagelayer.h"
+#include "imageloader.h"
+#include "project.h"
+#include "settings.h"
+#include "trace.h"
+#include "undocommands.h"
 #include "variable.h"
 #include <QMessageBox>
+#include <QSignalBlocker>
+#include <QUndoStack>
 
 /**
  * @brief Designer::Designer
  * @param parent
  */
-Designer::Designer( QWidget *parent ) : QMainWindow( parent ), ui( new Ui::Designer ), model( nullptr ), addMenu( new QMenu()) {
+Designer::Designer( QWidget *parent ) : QMainWindow( parent ), ui( new Ui::Designer ), model( nullptr ), addMenu( new QMenu()), imageLoader( new ImageLoader( this )), undoStack( new QUndoStack( this )), dragSerial( 0 ) {
     this->ui->setupUi( this );
 
+    // property edits are undoable
+    QAction *undoAction( this->undoStack->createUndoAction( this, this->tr( "Undo" )));
+    QAction *redoAction( this->undoStack->createRedoAction( this, this->tr( "Redo" )));
+    undoAction->setShortcuts( QKeySequence::Undo );
+    redoAction->setShortcuts( QKeySequence::Redo );
+    this->addAction( undoAction );
+    this->addAction( redoAction );
+    this->undoStack->setUndoLimit( UndoCommands_::Limit );
+
     // set up graphics view
     this->ui->graphicsView->setRenderHints( QPainter::Antialiasing | QPainter::SmoothPixmapTransform );
     this->ui->graphicsView->setHorizontalScrollBarPolicy( Qt::ScrollBarAlwaysOff );
@@ -58,42 +75,15 @@ Designer::Designer( QWidget *parent ) : QMainWindow( parent ), ui( new Ui::Desig
     this->setupShape();
     this->setupText();
 
-    // layer property change lambda
-    auto changeProperty = [ this ]( Properties property, const QVariant &value ) {
-        if ( this->currentLayer() == nullptr )
-            return;
-
-        if ( this->currentLayer()->item() == nullptr )
-            return;
-
-        switch ( property ) {
-        case Opacity:
-            this->currentLayer()->item()->setOpacity( value.toDouble() / 100.0 );
-            break;
-
-        case Scale:
-            this->currentLayer()->setScale( value.toDouble() / 100.0 );
-            break;
-
-        case HorizontalOffset:
-            this->currentLayer()->setHorizontalOffset( value.toInt());
-            break;
-
-        case VerticalOffset:
-            this->currentLayer()->setVerticalOffset( value.toInt());
-            break;
-
-        case NoProperty:
-            return;
-        }
-        this->currentLayer()->adjust();
-    };
-
     // property change triggers
-    this->connect( this->ui->opacitySlider, &QSlider::valueChanged, [ this, changeProperty ]( int value ) { changeProperty( Opacity, value ); } );
-    this->connect( this->ui->scaleSlider, &QSlider::valueChanged, [ this, changeProperty ]( int value ) { changeProperty( Scale, value ); } );
-    this->connect( this->ui->horizontalSlider, &QSlider::valueChanged, [ this, changeProperty ]( int value ) { changeProperty( HorizontalOffset, value ); } );
-    this->connect( this->ui->verticalSlider, &QSlider::valueChanged, [ this, changeProperty ]( int value ) { changeProperty( VerticalOffset, value ); } );
+    this->connect( this->ui->opacitySlider, &QSlider::valueChanged, [ this ]( int value ) { this->changeProperty( Opacity, value, this->ui->opacitySlider ); } );
+    this->connect( this->ui->scaleSlider, &QSlider::valueChanged, [ this ]( int value ) { this->changeProperty( Scale, value, this->ui->scaleSlider ); } );
+    this->connect( this->ui->horizontalSlider, &QSlider::valueChanged, [ this ]( int value ) { this->changeProperty( HorizontalOffset, value, this->ui->horizontalSlider ); } );
+    this->connect( this->ui->verticalSlider, &QSlider::valueChanged, [ this ]( int value ) { this->changeProperty( VerticalOffset, value, this->ui->verticalSlider ); } );
+
+    // every press starts a new drag (edits of separate drags are undone separately)
+    foreach ( QSlider *slider, QList<QSlider*>() << this->ui->opacitySlider << this->ui->scaleSlider << this->ui->horizontalSlider << this->ui->verticalSlider << this->ui->penSizeSlider )
+        this->connect( slider, &QSlider::sliderPressed, [ this ]() { this->dragSerial++; } );
 }
 
 /**
@@ -111,6 +101,145 @@ DesignerLayer *Designer::currentLayer() const {
     return this->layers.at( index.row());
 }
 
+/**
+ * @brief Designer::changeProperty pushes an undoable edit of the current layer
+ * @param property
+ * @param value
+ * @param slider control that changed, edits are merged while it is dragged
+ *
+ * Controls are also set when a layer is selected, which is not an edit
+ * (the value then matches the layer and nothing is pushed).
+ */
+void Designer::changeProperty( Properties property, const QVariant &value, const QSlider *slider ) {
+    DesignerLayer *layer( this->currentLayer());
+
+    if ( layer == nullptr || layer->item() == nullptr )
+        return;
+
+    const QVariant before( Designer::propertyValue( layer, property ));
+    if ( !before.isValid() || before == value )
+        return;
+
+    this->undoStack->push( new DesignerPropertyCommand( this, layer, property, before, value, slider != nullptr && slider->isSliderDown() ? this->dragSerial : UndoCommands_::NoDrag ));
+}
+
+/**
+ * @brief Designer::propertyValue returns a layer property in slider units
+ * @param layer
+ * @param property
+ * @return
+ */
+QVariant Designer::propertyValue( DesignerLayer *layer, Properties property ) {
+    if ( layer == nullptr || layer->item() == nullptr )
+        return QVariant();
+
+    switch ( property ) {
+    case Opacity:
+        return qRound( layer->item()->opacity() * 100 );
+
+    case Scale:
+        return qRound( layer->scale() * 100 );
+
+    case HorizontalOffset:
+        return layer->horizontalOffset();
+
+    case VerticalOffset:
+        return layer->verticalOffset();
+
+    case BezelFill:
+    case BezelStroke:
+    case BezelStrokeWidth:
+    {
+        const BezelLayer *bezel( qobject_cast<BezelLayer *>( layer ));
+        if ( bezel == nullptr )
+            break;
+
+        if ( property == BezelFill )
+            return bezel->style().fill;
+        else if ( property == BezelStroke )
+            return bezel->style().stroke;
+
+        return qRound( bezel->style().strokeWidth * layer->scene()->sceneRect().width());
+    }
+
+    case NoProperty:
+        break;
+    }
+    return QVariant();
+}
+
+/**
+ * @brief Designer::applyProperty sets a layer property and syncs its slider if the layer is selected
+ * @param layer
+ * @param property
+ * @param value
+ */
+void Designer::applyProperty( DesignerLayer *layer, Properties property, const QVariant &value ) {
+    QSlider *slider = nullptr;
+
+    if ( layer == nullptr || layer->item() == nullptr )
+        return;
+
+    switch ( property ) {
+    case Opacity:
+        layer->item()->setOpacity( value.toDouble() / 100.0 );
+        slider = this->ui->opacitySlider;
+        break;
+
+    case Scale:
+        layer->setScale( value.toDouble() / 100.0 );
+        slider = this->ui->scaleSlider;
+        break;
+
+    case HorizontalOffset:
+        layer->setHorizontalOffset( value.toInt());
+        slider = this->ui->horizontalSlider;
+        break;
+
+    case VerticalOffset:
+        layer->setVerticalOffset( value.toInt());
+        slider = this->ui->verticalSlider;
+        break;
+
+    case BezelFill:
+    case BezelStroke:
+    case BezelStrokeWidth:
+    {
+        BezelLayer *bezel( qobject_cast<BezelLayer *>( layer ));
+        if ( bezel == nullptr )
+            return;
+
+        BezelStyle style( bezel->style());
+        if ( property == BezelFill )
+            style.fill = value.value<QColor>();
+        else if ( property == BezelStroke )
+            style.stroke = value.value<QColor>();
+        else
+            style.strokeWidth = value.toDouble() / layer->scene()->sceneRect().width();
+        bezel->setStyle( style );
+
+        // refresh colour buttons (colours match now, so nothing is pushed)
+        if ( layer == this->currentLayer()) {
+            if ( property == BezelFill )
+                this->colourChanged( BrushTarget, style.fill );
+            else if ( property == BezelStroke )
+                this->colourChanged( PenTarget, style.stroke );
+        }
+        slider = property == BezelStrokeWidth ? this->ui->penSizeSlider : nullptr;
+    }
+        break;
+
+    case NoProperty:
+        return;
+    }
+    layer->adjust();
+
+    if ( slider != nullptr && layer == this->currentLayer()) {
+        const QSignalBlocker blocker( slider );
+        slider->setValue( value.toInt());
+    }
+}
+
 /**
  * @brief Designer::colourChanged
  * @param target
@@ -123,7 +252,15 @@ void Designer::colourChanged( ColourTarget target, const QColor &colour ) {
     pixmap.fill( colour );
     pixmap.setMask( mask );
 
-    if ( target == BrushTarget ) {
+    if (( target == BrushTarget || target == PenTarget ) && qobject_cast<BezelLayer *>( this->currentLayer()) != nullptr ) {
+        if ( target == BrushTarget ) {
+            this->ui->brushColourButton->setIcon( QIcon( pixmap ));
+            this->changeProperty( BezelFill, colour );
+        } else {
+            this->ui->penColourButton->setIcon( QIcon( pixmap ));
+            this->changeProperty( BezelStroke, colour );
+        }
+    } else if ( target == BrushTarget ) {
         ShapeLayer *shape( qobject_cast<ShapeLayer *>( this->currentLayer()));
         if ( shape == nullptr )
             return;
@@ -154,7 +291,7 @@ void Designer::colourChanged( ColourTarget target, const QColor &colour ) {
         if ( text == nullptr )
             return;
 
-        text->textItem->setDefaultTextColor( colour );
+        text->setColour( colour );
         this->ui->textColourButton->setIcon( QIcon( pixmap ));
     }
 }
@@ -210,9 +347,9 @@ void Designer::setupLayers() {
             if ( text == nullptr )
                 return;
 
-            this->ui->textEdit->setText( text->textItem->toPlainText());
+            this->ui->textEdit->setText( text->text());
             this->ui->pointSizeSlider->setValue( text->font.pointSize());
-            this->colourChanged( TextTarget, text->textItem->defaultTextColor());
+            this->colourChanged( TextTarget, text->colour());
             this->ui->fontCombo->setCurrentFont( text->font );
             this->ui->boldButton->setChecked( text->font.bold());
             this->ui->italicButton->setChecked( text->font.italic());
@@ -228,6 +365,17 @@ void Designer::setupLayers() {
             this->colourChanged( PenTarget, shape->pen.color());
             this->colourChanged( BrushTarget, shape->brush.color());
             this->ui->penSizeSlider->setValue( shape->pen.width());
+        } else if ( this->layers.at( index.row())->type() == DesignerLayer::Types::Bezel ) {
+            // bezels share the shape tools (pen is the stroke, brush the fill)
+            this->ui->stackedWidget->setCurrentIndex( Shape );
+
+            BezelLayer *bezel( qobject_cast<BezelLayer *>( this->currentLayer()));
+            if ( bezel == nullptr )
+                return;
+
+            this->colourChanged( PenTarget, bezel->style().stroke );
+            this->colourChanged( BrushTarget, bezel->style().fill );
+            this->ui->penSizeSlider->setValue( qRound( bezel->style().strokeWidth * this->scene->sceneRect().width()));
         } else if ( this->layers.at( index.row())->type() == DesignerLayer::Types::Image ) {
             this->ui->stackedWidget->setCurrentIndex( Image );
             //ImageLayer *image( qobject_cast<ImageLayer *>( this->currentLayer()));
@@ -237,20 +385,25 @@ void Designer::setupLayers() {
             this->ui->toolsDock->setEnabled( false );
 
         if ( this->currentLayer()->item() != nullptr ) {
-            this->ui->opacitySlider->setValue( static_cast<int>( this->currentLayer()->item()->opacity() * 100 ));
-            this->ui->scaleSlider->setValue( static_cast<int>( this->currentLayer()->scale() * 100 ));
-            this->ui->horizontalSlider->setValue( this->currentLayer()->horizontalOffset());
-            this->ui->verticalSlider->setValue( this->currentLayer()->verticalOffset());
+            this->ui->opacitySlider->setValue( Designer::propertyValue( this->currentLayer(), Opacity ).toInt());
+            this->ui->scaleSlider->setValue( Designer::propertyValue( this->currentLayer(), Scale ).toInt());
+            this->ui->horizontalSlider->setValue( Designer::propertyValue( this->currentLayer(), HorizontalOffset ).toInt());
+            this->ui->verticalSlider->setValue( Designer::propertyValue( this->currentLayer(), VerticalOffset ).toInt());
             this->currentLayer()->adjust();
         } else {
             this->ui->toolsDock->setEnabled( false );
         }
     } );
 
-    // add demo layers
+    // restore a composition opened before the designer was shown, or add demo layers
     // TODO: delete on close
-    this->addLayer( new ShapeLayer( this->scene, ShapeLayer::Shapes::Ellipse ));
-    this->addLayer( new TextLayer( this->scene, "Aa" ));
+    if ( !Designer::pending().second.isNull()) {
+        this->setComposition( Designer::pending().first, Designer::pending().second );
+        Designer::pending() = qMakePair( QVariantList(), QSharedPointer<Project>());
+    } else {
+        this->addLayer( new ShapeLayer( this->scene, ShapeLayer::Shapes::Ellipse ));
+        this->addLayer( new TextLayer( this->scene, "Aa" ));
+    }
 
     // reset model
     this->model->resetModel();
@@ -272,9 +425,9 @@ void Designer::setupLayers() {
     } );
     this->addMenu->addAction( this->tr( "Add ellipse item" ), [ this ]() { this->addLayer( new ShapeLayer( this->scene, ShapeLayer::Shapes::Ellipse )); } );
     this->addMenu->addAction( this->tr( "Add rectangle item" ), [ this ]() { this->addLayer( new ShapeLayer( this->scene, ShapeLayer::Shapes::Rectangle )); } );
+    this->addMenu->addAction( this->tr( "Add rounded bezel" ), [ this ]() { this->addLayer( new BezelLayer( this->scene, BezelStyle::Outlines::RoundedRect )); } );
+    this->addMenu->addAction( this->tr( "Add squircle bezel" ), [ this ]() { this->addLayer( new BezelLayer( this->scene, BezelStyle::Outlines::Squircle )); } );
     this->addMenu->addAction( this->tr( "Add image item" ), [ this ]() {
-        QPixmap pixmap;
-        bool ok;
         QString path( Variable::instance()->string( "previousOpenPath" ));
         const QDir dir( path );
 
@@ -282,9 +435,6 @@ void Designer::setupLayers() {
         if ( path.isEmpty() || !dir.exists())
             path = QDir::currentPath();
 
-        // failure by default
-        ok = false;
-
         // get fileName
         const QString fileName( QFileDialog::getOpenFileName( this, this->tr( "Open Image" ),
                                                               path,
@@ -293,33 +443,18 @@ void Designer::setupLayers() {
         if ( fileName.isEmpty())
             return;
 
-        // pre-render svs to maximum scale (ignores aspect ratio)
-        if ( fileName.endsWith( ".svg" )) {
-            QIcon icon;
-
-            icon.addFile( fileName, QSize( Ui::MaximumScale, Ui::MaximumScale ));
-            if ( icon.isNull()) {
-                QMessageBox::critical( this, this->tr( "Image selector" ),
-                                       this->tr( "Invalid svg. Try another one." ),
-                                       QMessageBox::Ok );
-            }
-
-            pixmap = icon.pixmap( Ui::ThresholdScale, Ui::ThresholdScale );
-        } else {
-            // validate pixmap
-            if ( !pixmap.load( fileName ))
+        // decode on a worker (svgs are pre-rendered to scene scale), then add layer
+        this->imageLoader->load( fileName, [ this ]( const QImage &image ) {
+            if ( image.isNull()) {
                 QMessageBox::critical( this, this->tr( "Image selector" ),
                                        this->tr( "Invalid image. Try another image." ),
                                        QMessageBox::Ok );
-        }
-
-        // check if pixmap is valid
-        if ( !pixmap.isNull())
-            ok = true;
+                return;
+            }
 
-        // finally add layer
-        if ( ok )
-            this->addLayer( new ImageLayer( this->scene, pixmap ));
+            this->addLayer( new ImageLayer( this->scene, QPixmap::fromImage( image )));
+            this->model->resetModel();
+        }, Ui::ThresholdScale );
     } );
 
     this->connect( this->ui->addButton, &QToolButton::clicked, [ this ]() {
@@ -355,7 +490,7 @@ void Designer::setupText() {
         if ( text == nullptr )
             return;
 
-        QColor colour( QColorDialog::getColor( text->textItem->defaultTextColor(), this ));
+        QColor colour( QColorDialog::getColor( text->colour(), this ));
         if ( !colour.isValid())
             return;
 
@@ -368,8 +503,9 @@ void Designer::setupText() {
         if ( text == nullptr )
             return;
 
-        text->font.setBold( enabled );
-        text->textItem->setFont( text->font );
+        QFont font( text->font );
+        font.setBold( enabled );
+        text->setFont( font );
         text->adjust();
     } );
 
@@ -379,8 +515,9 @@ void Designer::setupText() {
         if ( text == nullptr )
             return;
 
-        text->font.setItalic( enabled );
-        text->textItem->setFont( text->font );
+        QFont font( text->font );
+        font.setItalic( enabled );
+        text->setFont( font );
         text->adjust();
     } );
 
@@ -390,8 +527,9 @@ void Designer::setupText() {
         if ( text == nullptr )
             return;
 
-        text->font.setUnderline( enabled );
-        text->textItem->setFont( text->font );
+        QFont font( text->font );
+        font.setUnderline( enabled );
+        text->setFont( font );
         text->adjust();
     } );
 
@@ -401,8 +539,9 @@ void Designer::setupText() {
         if ( text == nullptr )
             return;
 
-        text->font.setFamily( font.family());
-        text->textItem->setFont( text->font );
+        QFont family( text->font );
+        family.setFamily( font.family());
+        text->setFont( family );
         text->adjust();
     } );
 }
@@ -414,10 +553,11 @@ void Designer::setupShape() {
     // brush colour picker lambda
     this->connect( this->ui->brushColourButton, &QPushButton::pressed, [ this ] () {
         ShapeLayer *shape( qobject_cast<ShapeLayer *>( this->currentLayer()));
-        if ( shape == nullptr )
+        BezelLayer *bezel( qobject_cast<BezelLayer *>( this->currentLayer()));
+        if ( shape == nullptr && bezel == nullptr )
             return;
 
-        QColor colour( QColorDialog::getColor( shape->brush.color(), this ));
+        QColor colour( QColorDialog::getColor( shape != nullptr ? shape->brush.color() : bezel->style().fill, this ));
         if ( !colour.isValid())
             return;
 
@@ -427,10 +567,11 @@ void Designer::setupShape() {
     // pen colour picker lambda
     this->connect( this->ui->penColourButton, &QPushButton::pressed, [ this ] () {
         ShapeLayer *shape( qobject_cast<ShapeLayer *>( this->currentLayer()));
-        if ( shape == nullptr )
+        BezelLayer *bezel( qobject_cast<BezelLayer *>( this->currentLayer()));
+        if ( shape == nullptr && bezel == nullptr )
             return;
 
-        QColor colour( QColorDialog::getColor( shape->pen.color(), this ));
+        QColor colour( QColorDialog::getColor( shape != nullptr ? shape->pen.color() : bezel->style().stroke, this ));
         if ( !colour.isValid())
             return;
 
@@ -452,11 +593,191 @@ void Designer::addLayer( DesignerLayer *layer ) {
         this->ui->layerView->setCurrentIndex( index );
 }
 
+/**
+ * @brief Designer::clearLayers removes all layers and their scene items
+ */
+void Designer::clearLayers() {
+    // commands refer to the layers
+    this->undoStack->clear();
+
+    foreach ( DesignerLayer *layer, this->layers ) {
+        delete layer->item();
+        delete layer;
+    }
+    this->layers.clear();
+}
+
+/**
+ * @brief Designer::loadComposition restores layers from a project
+ * @param composition
+ * @param project
+ *
+ * If the designer has not been opened yet, the composition (and decoding of
+ * its images) is deferred until it is.
+ */
+void Designer::loadComposition( const QVariantList &composition, const QSharedPointer<Project> &project ) {
+    if ( !Designer::isCreated()) {
+        Designer::pending() = qMakePair( composition, project );
+        return;
+    }
+
+    Designer::instance()->setComposition( composition, project );
+    Designer::instance()->model->resetModel();
+}
+
+/**
+ * @brief Designer::setComposition replaces layers with those of a stored composition
+ * @param composition
+ * @param project
+ */
+void Designer::setComposition( const QVariantList &composition, const QSharedPointer<Project> &project ) {
+    this->clearLayers();
+
+    foreach ( const QVariant &value, composition ) {
+        const QVariantMap map( value.toMap());
+        DesignerLayer *layer = nullptr;
+
+        switch ( static_cast<DesignerLayer::Types>( map["type"].toInt())) {
+        case DesignerLayer::Types::Shape:
+        {
+            ShapeLayer *shape( new ShapeLayer( this->scene, static_cast<ShapeLayer::Shapes>( map["shape"].toInt())));
+
+            shape->pen.setColor( map["pen"].value<QColor>());
+            shape->pen.setWidth( map["penWidth"].toInt());
+            shape->brush.setColor( map["brush"].value<QColor>());
+
+            if ( shape->ellipseItem != nullptr ) {
+                shape->ellipseItem->setPen( shape->pen );
+                shape->ellipseItem->setBrush( shape->brush );
+            } else if ( shape->rectItem != nullptr ) {
+                shape->rectItem->setPen( shape->pen );
+                shape->rectItem->setBrush( shape->brush );
+            }
+            layer = shape;
+        }
+            break;
+
+        case DesignerLayer::Types::Text:
+        {
+            TextLayer *text( new TextLayer( this->scene, map["text"].toString()));
+
+            text->setFont( map["font"].value<QFont>());
+            text->setColour( map["colour"].value<QColor>());
+            text->textScale = map.value( "scale", 1.0 ).toDouble();
+            layer = text;
+        }
+            break;
+
+        case DesignerLayer::Types::Image:
+            layer = new ImageLayer( this->scene, QPixmap::fromImage( project->image( map["image"].toByteArray())));
+            break;
+
+        case DesignerLayer::Types::Bezel:
+        {
+            BezelLayer *bezel( new BezelLayer( this->scene, static_cast<BezelStyle::Outlines>( map["outline"].toInt())));
+            BezelStyle style( bezel->style());
+
+            style.radius = map.value( "radius", style.radius ).toDouble();
+            style.exponent = map.value( "exponent", style.exponent ).toDouble();
+            style.fill = map.value( "fill", style.fill ).value<QColor>();
+            style.stroke = map.value( "stroke", style.stroke ).value<QColor>();
+            style.strokeWidth = map.value( "strokeWidth", style.strokeWidth ).toDouble();
+            style.bevel = map.value( "bevel", style.bevel ).toDouble();
+            style.bevelStrength = map.value( "bevelStrength", style.bevelStrength ).toDouble();
+            style.glow = map.value( "glow", style.glow ).value<QColor>();
+            style.glowWidth = map.value( "glowWidth", style.glowWidth ).toDouble();
+            bezel->setStyle( style );
+            layer = bezel;
+        }
+            break;
+
+        case DesignerLayer::Types::NoType:
+            break;
+        }
+
+        if ( layer == nullptr )
+            continue;
+
+        layer->setName( map["name"].toString());
+        layer->setHorizontalOffset( map["horizontalOffset"].toInt());
+        layer->setVerticalOffset( map["verticalOffset"].toInt());
+        if ( layer->type() != DesignerLayer::Types::Text )
+            layer->setScale( map["scale"].toDouble()); // text scale is stored as the font point size
+        if ( layer->item() != nullptr )
+            layer->item()->setOpacity( map.value( "opacity", 1.0 ).toDouble());
+        layer->adjust();
+
+        this->addLayer( layer );
+    }
+}
+
+/**
+ * @brief Designer::composition returns layer properties for a project (images go to writer)
+ * @param writer
+ * @return
+ */
+QVariantList Designer::composition( ProjectWriter &writer ) const {
+    QVariantList composition;
+
+    foreach ( DesignerLayer *layer, this->layers ) {
+        QVariantMap map;
+
+        map["type"] = static_cast<int>( layer->type());
+        map["name"] = layer->name();
+        map["horizontalOffset"] = layer->horizontalOffset();
+        map["verticalOffset"] = layer->verticalOffset();
+        map["scale"] = layer->scale();
+        if ( layer->item() != nullptr )
+            map["opacity"] = layer->item()->opacity();
+
+        if ( layer->type() == DesignerLayer::Types::Shape ) {
+            const ShapeLayer *shape( qobject_cast<ShapeLayer*>( layer ));
+
+            map["shape"] = static_cast<int>( shape->shape());
+            map["pen"] = shape->pen.color();
+            map["penWidth"] = shape->pen.width();
+            map["brush"] = shape->brush.color();
+        } else if ( layer->type() == DesignerLayer::Types::Text ) {
+            const TextLayer *text( qobject_cast<TextLayer*>( layer ));
+
+            map["text"] = text->text();
+            map["font"] = text->font;
+            map["colour"] = text->colour();
+        } else if ( layer->type() == DesignerLayer::Types::Image ) {
+            const ImageLayer *image( qobject_cast<ImageLayer*>( layer ));
+
+            map["image"] = writer.addImage( image->pixmapItem->pixmap().toImage());
+        } else if ( layer->type() == DesignerLayer::Types::Bezel ) {
+            const BezelStyle style( qobject_cast<BezelLayer*>( layer )->style());
+
+            map["outline"] = static_cast<int>( style.outline );
+            map["radius"] = style.radius;
+            map["exponent"] = style.exponent;
+            map["fill"] = style.fill;
+            map["stroke"] = style.stroke;
+            map["strokeWidth"] = style.strokeWidth;
+            map["bevel"] = style.bevel;
+            map["bevelStrength"] = style.bevelStrength;
+            map["glow"] = style.glow;
+            map["glowWidth"] = style.glowWidth;
+        }
+
+        composition << map;
+    }
+
+    return composition;
+}
+
 /**
  * @brief Designer::on_penSizeSlider_valueChanged
  * @param value
  */
 void Designer::on_penSizeSlider_valueChanged( int value ) {
+    if ( qobject_cast<BezelLayer *>( this->currentLayer()) != nullptr ) {
+        this->changeProperty( BezelStrokeWidth, value, this->ui->penSizeSlider );
+        return;
+    }
+
     ShapeLayer *shape( qobject_cast<ShapeLayer *>( this->currentLayer()));
     if ( shape == nullptr )
         return;
@@ -478,7 +799,7 @@ void Designer::on_textEdit_textChanged( const QString &text ) {
     if ( textLayer == nullptr )
         return;
 
-    textLayer->textItem->setPlainText( text );
+    textLayer->setText( text );
     textLayer->adjust();
 }
 
@@ -491,8 +812,7 @@ void Designer::on_pointSizeSlider_valueChanged( int value ) {
     if ( textLayer == nullptr )
         return;
 
-    textLayer->font.setPointSize( value );
-    textLayer->textItem->setFont( textLayer->font );
+    textLayer->setPointSize( value );
     textLayer->adjust();
 }
 
@@ -500,16 +820,48 @@ void Designer::on_pointSizeSlider_valueChanged( int value ) {
  * @brief Designer::on_exportButton_clicked
  */
 void Designer::on_exportButton_clicked() {
-    QPixmap pixmap( 512, 512 );
+    const TraceScope trace( "Designer::on_exportButton_clicked" );
+
+    QList<int> scales;
+    QMap<int, QImage> renders;
+
+    // every template size is rendered from the scene directly (bezels and glyphs rasterize
+    // at that size); renders are a snapshot, later edits in the designer do not leak into
+    // layers generated from this export (other sizes are downscaled from the full render)
+    for ( int y = 0; y < Settings::TemplateCount; y++ )
+        scales << Settings::layerTemplate( static_cast<Settings::Templates>( y )).scales;
+    foreach ( const Ui::macOSLayer &layer, Ui::macOSLayers )
+        scales << layer.scale;
+
+    foreach ( const int scale, scales ) {
+        if ( scale >= Ui::MinimumScale && scale <= Ui::MaximumScale && !renders.contains( scale ))
+            renders[scale] = Designer::renderScene( this->scene, scale ).toImage();
+    }
+
+    MainWindow::instance()->setPixmap( Designer::renderScene( this->scene ), [ renders ]( int scale ) {
+        return renders.value( scale );
+    } );
+    this->close();
+}
+
+/**
+ * @brief Designer::renderScene renders a composition without its background
+ * @param scene
+ * @param scale
+ * @return
+ */
+QPixmap Designer::renderScene( QGraphicsScene *scene, int scale ) {
+    const TraceScope trace( "QGraphicsScene::render" );
+    QPixmap pixmap( scale, scale );
     pixmap.fill( Qt::transparent );
     QPainter painter( &pixmap );
 
-    QBrush background( this->scene->backgroundBrush());
-    this->scene->setBackgroundBrush( QBrush( Qt::transparent ));
+    const QBrush background( scene->backgroundBrush());
+    scene->setBackgroundBrush( QBrush( Qt::transparent ));
     painter.setRenderHint( QPainter::Antialiasing );
-    this->scene->render( &painter );
-    MainWindow::instance()->setPixmap( pixmap );
-    this->scene->setBackgroundBrush( background );
+    scene->render( &painter );
+    painter.end();
+    scene->setBackgroundBrush( background );
 
-    this->close();
+    return pixmap;
 }
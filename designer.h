@@ -25,6 +25,9 @@
 #include <QMainWindow>
 #include <QMenu>
 #include <QPen>
+#include <QSharedPointer>
+#include <QSlider>
+#include <QVariantList>
 #include "designerlayer.h"
 
 /**
@@ -39,6 +42,10 @@ class Designer;
 //
 //class DesignerLayer;
 class DesignerModel;
+class ImageLoader;
+class Project;
+class ProjectWriter;
+class QUndoStack;
 
 /**
  * @brief The MainWindow class
@@ -49,6 +56,7 @@ class Designer final : public QMainWindow {
     Q_DISABLE_COPY( Designer )
     Q_ENUMS( ToolPages )
     Q_ENUMS( Properties )
+    friend class DesignerPropertyCommand;
 
 public:
     enum ColourTarget {
@@ -70,11 +78,28 @@ public:
         Opacity,
         Scale,
         HorizontalOffset,
-        VerticalOffset
+        VerticalOffset,
+        BezelFill,
+        BezelStroke,
+        BezelStrokeWidth
     };
 
-    static Designer *instance() { static Designer *instance = new Designer(); return instance; }
+    /**
+     * @brief instance constructs the designer (and its demo layers) on first use
+     * @return
+     */
+    static Designer *instance() {
+        if ( Designer::pointer() == nullptr ) {
+            Designer::pointer() = new Designer();
+            Designer::pointer()->setupLayers();
+        }
+        return Designer::pointer();
+    }
+    static bool isCreated() { return Designer::pointer() != nullptr; }
     ~Designer();
+    static QPixmap renderScene( QGraphicsScene *scene, int scale = 512 );
+    static void loadComposition( const QVariantList &composition, const QSharedPointer<Project> &project );
+    QVariantList composition( ProjectWriter &writer ) const;
     QList<DesignerLayer*> layers;
 
 public slots:
@@ -92,10 +117,20 @@ private slots:
 
 private:
     explicit Designer( QWidget *parent = nullptr );
+    static Designer *&pointer() { static Designer *instance = nullptr; return instance; }
+    static QPair<QVariantList, QSharedPointer<Project> > &pending() { static QPair<QVariantList, QSharedPointer<Project> > pending; return pending; }
+    void setComposition( const QVariantList &composition, const QSharedPointer<Project> &project );
+    void clearLayers();
+    static QVariant propertyValue( DesignerLayer *layer, Properties property );
+    void changeProperty( Properties property, const QVariant &value, const QSlider *slider = nullptr );
+    void applyProperty( DesignerLayer *layer, Properties property, const QVariant &value );
     Ui::Designer *ui;
     QGraphicsScene *scene;
     DesignerModel *model;
     QMap<int, DesignerLayer*> layerMap;
     DesignerLayer *currentLayer() const;
     QMenu *addMenu;
+    ImageLoader *imageLoader;
+    QUndoStack *undoStack;
+    int dragSerial;
 };
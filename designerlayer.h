@@ -64,6 +64,7 @@ public:
     virtual int horizontalOffset() const { return this->m_horizontalOffset; }
     virtual int verticalOffset() const { return this->m_verticalOffset; }
     virtual qreal scale() const { return this->m_scale; }
+    virtual qint64 pixelBytes() const { return 0; }
 
     /**
      * @brief item
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "glyphcache.h"
+#include "trace.h"
+#include <QCache>
+#include <QFontMetricsF>
+#include <QGlyphRun>
+#include <QMutex>
+#include <QRawFont>
+#include <QTextLayout>
+
+/**
+ * @brief GlyphCache::outline returns the (cached) outline of text set in font
+ * @param font
+ * @param text
+ * @return
+ */
+QPainterPath GlyphCache::outline( const QFont &font, const QString &text ) {
+    static QMutex mutex;
+    static QCache<QString, QPainterPath> cache( GlyphCache_::CacheSize );
+    const QString key( font.key() + QChar( '\n' ) + text );
+
+    {
+        QMutexLocker lock( &mutex );
+        if ( cache.contains( key ))
+            return *cache.object( key );
+    }
+
+    const QPainterPath path( GlyphCache::shape( font, text ));
+    QMutexLocker lock( &mutex );
+    cache.insert( key, new QPainterPath( path ), qBound( 1, path.elementCount(), GlyphCache_::CacheSize ));
+
+    return path;
+}
+
+/**
+ * @brief GlyphCache::shape lays out text (single line) and collects its glyph outlines
+ * @param font
+ * @param text
+ * @return
+ */
+QPainterPath GlyphCache::shape( const QFont &font, const QString &text ) {
+    const TraceScope trace( "GlyphCache::shape" );
+    QTextLayout layout( text, font );
+    QPainterPath path;
+
+    layout.beginLayout();
+    QTextLine line( layout.createLine());
+    if ( line.isValid())
+        line.setPosition( QPointF( 0.0, 0.0 ));
+    layout.endLayout();
+
+    if ( !line.isValid())
+        return path;
+
+    foreach ( const QGlyphRun &run, layout.glyphRuns()) {
+        const QRawFont rawFont( run.rawFont());
+        const QVector<quint32> indexes( run.glyphIndexes());
+        const QVector<QPointF> positions( run.positions());
+
+        for ( int y = 0; y < indexes.count(); y++ )
+            path.addPath( rawFont.pathForGlyph( indexes.at( y )).translated( positions.at( y )));
+    }
+
+    // glyph runs carry no decorations
+    if ( font.underline()) {
+        const QFontMetricsF metrics( font );
+        path.addRect( QRectF( 0.0, line.ascent() + metrics.underlinePos(), line.naturalTextWidth(), metrics.lineWidth()));
+    }
+
+    path.setFillRule( Qt::WindingFill );
+    return path;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QFont>
+#include <QPainterPath>
+#include <QString>
+
+/**
+ * @brief The GlyphCache_ namespace
+ */
+namespace GlyphCache_ {
+constexpr int CacheSize = 256 * 1024; // total path elements kept
+}
+
+/**
+ * @brief The GlyphCache class shapes text once and keeps the resulting glyph outlines
+ *
+ * Text is shaped with QTextLayout and the glyph runs (QGlyphRun/QRawFont) are
+ * converted to a single outline path. Outlines are keyed by font and text, so
+ * callers that render the same text at several sizes should shape it at one
+ * reference size and scale the outline with a transform.
+ */
+class GlyphCache final {
+public:
+    static QPainterPath outline( const QFont &font, const QString &text );
+
+private:
+    static QPainterPath shape( const QFont &font, const QString &text );
+};
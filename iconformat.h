@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+#pragma once
+
+//
+// includes
+//
+#include <QList>
+#include <QString>
+
+/**
+ * @brief The IconFormat namespace (limits and icns type codes shared by the core library)
+ */
+namespace IconFormat {
+constexpr int MinimumScale = 4;
+constexpr int ThresholdScale = 256;
+constexpr int MaximumScale = 1024;
+constexpr int AlphaThreshold = 128; // pixels below are transparent in masks and palettes
+
+struct macOSLayer {
+    QString code;
+    int scale;
+    bool doubleScale;
+    macOSLayer( const QString &c, int scale, bool doubleScale = false ) : code( c ), scale( scale ), doubleScale( doubleScale ) {}
+};
+
+static const QList<macOSLayer> macOSLayers = QList<macOSLayer>() <<
+                                                                    macOSLayer( "icp4", 16 ) <<
+                                                                    macOSLayer( "icp5", 32 ) <<
+                                                                    macOSLayer( "icp6", 64 ) <<
+                                                                    macOSLayer( "ic07", 128 ) <<
+                                                                    macOSLayer( "ic08", 256 ) <<
+                                                                    macOSLayer( "ic09", 512 ) <<
+                                                                    macOSLayer( "ic10", 1024 ) <<
+                                                                    macOSLayer( "ic11", 32, true ) <<
+                                                                    macOSLayer( "ic12", 64, true ) <<
+                                                                    macOSLayer( "ic13", 256, true ) <<
+                                                                    macOSLayer( "ic14", 512, true );
+
+struct macOSLegacyLayer {
+    QString code;
+    QString maskCode;
+    int scale;
+    macOSLegacyLayer( const QString &c, const QString &m, int scale ) : code( c ), maskCode( m ), scale( scale ) {}
+};
+
+static const QList<macOSLegacyLayer> macOSLegacyLayers = QList<macOSLegacyLayer>() <<
+                                                                                macOSLegacyLayer( "is32", "s8mk", 16 ) <<
+                                                                                macOSLegacyLayer( "il32", "l8mk", 32 ) <<
+                                                                                macOSLegacyLayer( "ih32", "h8mk", 48 ) <<
+                                                                                macOSLegacyLayer( "it32", "t8mk", 128 );
+
+/**
+ * @brief macOSCode returns icns type code for the given layer scale
+ * @param scale
+ * @param doubleScale
+ * @return
+ */
+inline static QString macOSCode( int scale, bool doubleScale ) {
+    foreach ( const macOSLayer &layer, macOSLayers ) {
+        if ( layer.scale == scale && layer.doubleScale == doubleScale )
+            return layer.code;
+    }
+    return QString();
+}
+}
@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "iconreader.h"
+#include "iconwriter.h"
+#include "iconformat.h"
+#include "packbits.h"
+#include <QMap>
+#include <QPair>
+#include <QtEndian>
+
+/**
+ * @brief IconReader::read maps an .ico or .icns file and creates deferred layers
+ * @param filename
+ * @param macOS set to true for icns files
+ * @return
+ */
+QList<Layer*> IconReader::read( const QString &filename, bool *macOS ) const {
+    QSharedPointer<QFile> file( new QFile( filename ));
+    QList<Layer*> layers;
+
+    if ( !file->open( QIODevice::ReadOnly ) || file->size() < static_cast<qint64>( sizeof( IcoHeader )))
+        return layers;
+
+    // map the whole file; layers keep the mapping alive until decoded
+    const qint64 size = file->size();
+    const uchar *data = file->map( 0, size );
+    if ( data == nullptr )
+        return layers;
+
+    // icns headers are type and length (8 bytes)
+    if ( size < 8 )
+        return layers;
+
+    const bool icns = !memcmp( data, "icns", 4 );
+    if ( macOS != nullptr )
+        *macOS = icns;
+
+    return icns ? this->readIcns( file, data, size ) : this->readIco( file, data, size );
+}
+
+/**
+ * @brief IconReader::readIco
+ * @param file
+ * @param data
+ * @param size
+ * @return
+ */
+QList<Layer*> IconReader::readIco( const QSharedPointer<QFile> &file, const uchar *data, qint64 size ) const {
+    QMap<int, int> depths;
+    QMap<int, Layer*> layers;
+    int y;
+
+    // validate header
+    if ( qFromLittleEndian<quint16>( data ) != 0 || qFromLittleEndian<quint16>( data + 2 ) != 1 )
+        return QList<Layer*>();
+
+    const int count = qFromLittleEndian<quint16>( data + 4 );
+    if ( static_cast<qint64>( sizeof( IcoHeader ) + sizeof( IcoDirectory ) * static_cast<size_t>( count )) > size )
+        return QList<Layer*>();
+
+    for ( y = 0; y < count; y++ ) {
+        const uchar *entry = data + sizeof( IcoHeader ) + sizeof( IcoDirectory ) * static_cast<size_t>( y );
+        int scale = entry[0] ? entry[0] : 256;
+        int depth = qFromLittleEndian<quint16>( entry + 6 );
+        const quint32 bytes = qFromLittleEndian<quint32>( entry + 8 );
+        const quint32 offset = qFromLittleEndian<quint32>( entry + 12 );
+
+        if ( static_cast<qint64>( offset ) + bytes > size || bytes < sizeof( BitmapHeader ))
+            continue;
+
+        // png entries store real dimensions in IHDR
+        const uchar *payload = data + offset;
+        const bool png = !memcmp( payload, "\x89PNG\r\n\x1a\n", 8 );
+        if ( png ) {
+            scale = static_cast<int>( qFromBigEndian<quint32>( payload + 16 ));
+            depth = 32;
+        } else if ( depth == 0 ) {
+            depth = qFromLittleEndian<quint16>( payload + 14 );
+        }
+
+        // keep the deepest entry for each scale
+        if ( scale < IconFormat::MinimumScale || scale > IconFormat::MaximumScale || ( depths.contains( scale ) && depths[scale] >= depth ))
+            continue;
+
+        Layer *layer( layers.value( scale, nullptr ));
+        if ( layer == nullptr ) {
+            layer = new Layer();
+            layers[scale] = layer;
+        }
+
+        depths[scale] = depth;
+        layer->setScale( scale );
+        layer->setOverriden( true );
+        layer->setEncoding( png ? Layer::Encodings::PNG : ( depth <= 8 ? Layer::Encodings::Palette : Layer::Encodings::Bitmap ));
+        layer->setDecoder( [ file, payload, bytes, png ]() {
+            Q_UNUSED( file )
+            return png ? QImage::fromData( payload, static_cast<int>( bytes ), "PNG" ) : IconReader::decodeBitmap( payload, bytes );
+        } );
+        layer->setStoredBytes( bytes );
+    }
+
+    return layers.values();
+}
+
+/**
+ * @brief IconReader::readIcns
+ * @param file
+ * @param data
+ * @param size
+ * @return
+ */
+QList<Layer*> IconReader::readIcns( const QSharedPointer<QFile> &file, const uchar *data, qint64 size ) const {
+    QMap<QString, QPair<const uchar*, quint32> > records;
+    QList<Layer*> layers;
+    QList<int> scales;
+    qint64 pos = 8;
+
+    // clamp to declared length
+    size = qMin( size, static_cast<qint64>( qFromBigEndian<quint32>( data + 4 )));
+
+    // walk type/length records
+    while ( pos + 8 <= size ) {
+        const QString code( QString::fromLatin1( reinterpret_cast<const char*>( data + pos ), 4 ));
+        const quint32 length = qFromBigEndian<quint32>( data + pos + 4 );
+
+        if ( length < 8 || pos + length > size )
+            break;
+
+        if ( !records.contains( code ))
+            records[code] = qMakePair( data + pos + 8, length - 8 );
+
+        pos += length;
+    }
+
+    // modern png/jpeg2000 entries
+    foreach ( const IconFormat::macOSLayer &type, IconFormat::macOSLayers ) {
+        if ( !records.contains( type.code ))
+            continue;
+
+        const uchar *payload = records[type.code].first;
+        const quint32 bytes = records[type.code].second;
+        Layer *layer( new Layer());
+
+        layer->setScale( type.scale );
+        layer->setDoubleScale( type.doubleScale );
+        layer->setOverriden( true );
+        layer->setCompressed( true );
+        layer->setDecoder( [ file, payload, bytes ]() {
+            Q_UNUSED( file )
+            return QImage::fromData( payload, static_cast<int>( bytes ));
+        } );
+        layer->setStoredBytes( bytes );
+
+        if ( !type.doubleScale )
+            scales << type.scale;
+        layers << layer;
+    }
+
+    // legacy rle entries, unless a modern entry of the same scale exists
+    foreach ( const IconFormat::macOSLegacyLayer &type, IconFormat::macOSLegacyLayers ) {
+        if ( !records.contains( type.code ) || scales.contains( type.scale ) || IconFormat::macOSCode( type.scale, false ).isEmpty())
+            continue;
+
+        const QPair<const uchar*, quint32> rle( records[type.code] );
+        const QPair<const uchar*, quint32> mask( records.value( type.maskCode, qMakePair( static_cast<const uchar*>( nullptr ), 0U )));
+        const int scale = type.scale;
+        const bool prefix = type.code == "it32";
+        Layer *layer( new Layer());
+
+        layer->setScale( scale );
+        layer->setOverriden( true );
+        layer->setCompressed( true );
+        layer->setDecoder( [ file, rle, mask, scale, prefix ]() {
+            Q_UNUSED( file )
+            return IconReader::decodeLegacy( rle.first, rle.second, mask.first, mask.second, scale, prefix );
+        } );
+        layer->setStoredBytes( rle.second + mask.second + 8 );
+
+        scales << type.scale;
+        layers << layer;
+    }
+
+    return layers;
+}
+
+/**
+ * @brief IconReader::decodeLegacy decodes a per-channel rle entry and its 8-bit mask
+ * @param data
+ * @param size
+ * @param mask may be nullptr for opaque images
+ * @param maskSize
+ * @param scale
+ * @param prefix it32 entries start with four zero bytes
+ * @return
+ */
+QImage IconReader::decodeLegacy( const uchar *data, quint32 size, const uchar *mask, quint32 maskSize, int scale, bool prefix ) {
+    const int pixels = scale * scale;
+    QByteArray channels;
+    int pos = prefix ? 4 : 0;
+    int k, y, x;
+
+    if ( static_cast<quint32>( pos ) > size )
+        return QImage();
+
+    // channels are stored planar: red, green, blue
+    channels.reserve( pixels * 3 );
+    for ( k = 0; k < 3; k++ ) {
+        int consumed = 0;
+
+        if ( !PackBits::decode( channels, data + pos, static_cast<int>( size ) - pos, pixels, &consumed ))
+            return QImage();
+
+        pos += consumed;
+    }
+
+    QImage image( scale, scale, QImage::Format_ARGB32 );
+    const bool hasMask = mask != nullptr && maskSize >= static_cast<quint32>( pixels );
+    for ( y = 0; y < scale; y++ ) {
+        QRgb *out = reinterpret_cast<QRgb*>( image.scanLine( y ));
+
+        for ( x = 0; x < scale; x++ ) {
+            const int index = y * scale + x;
+            out[x] = qRgba( static_cast<uchar>( channels.at( index )),
+                            static_cast<uchar>( channels.at( pixels + index )),
+                            static_cast<uchar>( channels.at( pixels * 2 + index )),
+                            hasMask ? mask[index] : 255 );
+        }
+    }
+
+    return image;
+}
+
+/**
+ * @brief IconReader::decodeBitmap decodes a headerless DIB stored in an ico
+ * @param data
+ * @param size
+ * @return
+ */
+QImage IconReader::decodeBitmap( const uchar *data, qint64 size ) {
+    if ( size < static_cast<qint64>( sizeof( BitmapHeader )))
+        return QImage();
+
+    const quint32 headerSize = qFromLittleEndian<quint32>( data );
+    const int width = qFromLittleEndian<qint32>( data + 4 );
+    const int height = qFromLittleEndian<qint32>( data + 8 ) / 2;
+    const int depth = qFromLittleEndian<quint16>( data + 14 );
+    const quint32 compression = qFromLittleEndian<quint32>( data + 16 );
+    quint32 colours = qFromLittleEndian<quint32>( data + 32 );
+    int y, x;
+
+    if ( compression != 0 || width <= 0 || height <= 0 || width > IconFormat::MaximumScale || height > IconFormat::MaximumScale )
+        return QImage();
+
+    if ( depth != 1 && depth != 4 && depth != 8 && depth != 24 && depth != 32 )
+        return QImage();
+
+    if ( depth <= 8 && colours == 0 )
+        colours = 1U << depth;
+    else if ( depth > 8 )
+        colours = 0;
+
+    // check bounds before forming any pointer (header fields come from the file)
+    const int stride = (( width * depth + 31 ) / 32 ) * 4;
+    const int maskStride = IconWriter::maskBytesPerRow( width );
+    if ( headerSize < sizeof( BitmapHeader ) || colours > 256 ||
+         static_cast<qint64>( headerSize ) + colours * 4 + static_cast<qint64>( stride ) * height + static_cast<qint64>( maskStride ) * height > size )
+        return QImage();
+
+    const uchar *palette = data + headerSize;
+    const uchar *pixels = palette + colours * 4;
+    const uchar *mask = pixels + stride * height;
+
+    QImage image( width, height, QImage::Format_ARGB32 );
+    bool hasAlpha = false;
+
+    for ( y = 0; y < height; y++ ) {
+        const uchar *row = pixels + stride * ( height - y - 1 );
+        const uchar *maskRow = mask + maskStride * ( height - y - 1 );
+        QRgb *out = reinterpret_cast<QRgb*>( image.scanLine( y ));
+
+        for ( x = 0; x < width; x++ ) {
+            const bool transparent = maskRow[x / 8] & ( 0x80 >> ( x % 8 ));
+            QRgb colour;
+
+            if ( depth == 32 ) {
+                colour = qRgba( row[x * 4 + 2], row[x * 4 + 1], row[x * 4], row[x * 4 + 3] );
+                hasAlpha |= qAlpha( colour ) != 0;
+            } else if ( depth == 24 ) {
+                colour = qRgb( row[x * 3 + 2], row[x * 3 + 1], row[x * 3] );
+            } else {
+                const int bit = x * depth;
+                const quint32 index = ( row[bit / 8] >> ( 8 - depth - bit % 8 )) & (( 1U << depth ) - 1 );
+                const uchar *entry = palette + ( index < colours ? index : 0 ) * 4;
+                colour = qRgb( entry[2], entry[1], entry[0] );
+            }
+
+            out[x] = ( depth == 32 || !transparent ) ? colour : qRgba( 0, 0, 0, 0 );
+        }
+    }
+
+    // old 32-bit entries leave alpha empty and rely on the mask
+    if ( depth == 32 && !hasAlpha ) {
+        for ( y = 0; y < height; y++ ) {
+            const uchar *maskRow = mask + maskStride * ( height - y - 1 );
+            QRgb *out = reinterpret_cast<QRgb*>( image.scanLine( y ));
+
+            for ( x = 0; x < width; x++ )
+                out[x] = ( maskRow[x / 8] & ( 0x80 >> ( x % 8 ))) ? qRgba( 0, 0, 0, 0 ) : ( out[x] | 0xff000000 );
+        }
+    }
+
+    return image;
+}
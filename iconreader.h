@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QFile>
+#include <QImage>
+#include <QSharedPointer>
+#include "layer.h"
+
+/**
+ * @brief The IconReader class
+ */
+class IconReader final {
+public:
+    IconReader() = default;
+    ~IconReader() = default;
+    QList<Layer*> read( const QString &filename, bool *macOS = nullptr ) const;
+    static QImage decodeBitmap( const uchar *data, qint64 size );
+    static QImage decodeLegacy( const uchar *data, quint32 size, const uchar *mask, quint32 maskSize, int scale, bool prefix = false );
+
+private:
+    QList<Layer*> readIco( const QSharedPointer<QFile> &file, const uchar *data, qint64 size ) const;
+    QList<Layer*> readIcns( const QSharedPointer<QFile> &file, const uchar *data, qint64 size ) const;
+};
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+//
+// includes
+//
+#include "iconsource.h"
+#include "iconformat.h"
+#include "trace.h"
+#include <QBuffer>
+#include <QImageReader>
+
+/**
+ * @brief decode decodes an image, pre-rendering svgs to the given scale (ignores aspect ratio)
+ * @param reader
+ * @param svgScale
+ * @return
+ */
+static QImage decode( QImageReader &reader, int svgScale = IconFormat::MaximumScale ) {
+    if ( reader.format() == "svg" || reader.format() == "svgz" )
+        reader.setScaledSize( QSize( svgScale, svgScale ));
+
+    return reader.read();
+}
+
+/**
+ * @brief IconSource::decode reads an image file without fitting it
+ * @param fileName
+ * @param svgScale svgs are rendered at this scale
+ * @return
+ */
+QImage IconSource::decode( const QString &fileName, int svgScale ) {
+    const TraceScope trace( "IconSource::decode" );
+    QImageReader reader( fileName );
+
+    return ::decode( reader, svgScale );
+}
+
+/**
+ * @brief IconSource::fromFile
+ * @param fileName
+ * @return
+ */
+IconSource IconSource::fromFile( const QString &fileName ) {
+    return IconSource( IconSource::decode( fileName ));
+}
+
+/**
+ * @brief IconSource::fromData
+ * @param data encoded image (png, jpg, bmp, svg, ...)
+ * @return
+ */
+IconSource IconSource::fromData( const QByteArray &data ) {
+    QBuffer buffer;
+
+    buffer.setData( data );
+    buffer.open( QIODevice::ReadOnly );
+    QImageReader reader( &buffer );
+
+    return IconSource( ::decode( reader ));
+}
+
+/**
+ * @brief IconSource::fitImage limits image to maximum layer scale
+ * @param image
+ * @return
+ */
+QImage IconSource::fitImage( const QImage &image ) {
+    QImage scaled( image );
+
+    // resize if larger than 1024
+    if ( scaled.width() > IconFormat::MaximumScale || scaled.height() > IconFormat::MaximumScale ) {
+        if ( scaled.width() > scaled.height())
+            scaled = scaled.scaledToHeight( IconFormat::MaximumScale, Qt::SmoothTransformation );
+        else if ( scaled.width() < scaled.height())
+            scaled = scaled.scaledToWidth( IconFormat::MaximumScale, Qt::SmoothTransformation );
+        else
+            scaled = scaled.scaled( IconFormat::MaximumScale, IconFormat::MaximumScale, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+    }
+
+    return scaled;
+}
+
+/**
+ * @brief IconSource::isValid
+ * @return
+ */
+bool IconSource::isValid() const {
+    return !this->m_image.isNull() && this->m_image.width() >= IconFormat::MinimumScale && this->m_image.height() >= IconFormat::MinimumScale;
+}
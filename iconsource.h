@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+#pragma once
+
+//
+// includes
+//
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+#include "iconformat.h"
+
+/**
+ * @brief The IconSource class holds a decoded source image fitted to the maximum layer scale
+ *
+ * Sources are implicitly shared values and can be passed between threads.
+ */
+class IconSource final {
+public:
+    explicit IconSource( const QImage &image = QImage()) : m_image( IconSource::fitImage( image )) {}
+    ~IconSource() = default;
+    static IconSource fromFile( const QString &fileName );
+    static IconSource fromData( const QByteArray &data );
+    static QImage decode( const QString &fileName, int svgScale = IconFormat::MaximumScale );
+    static QImage fitImage( const QImage &image );
+    const QImage &image() const { return this->m_image; }
+    bool isValid() const;
+
+private:
+    QImage m_image;
+};
@@ -20,87 +20,427 @@
 // includes
 //
 #include "iconwriter.h"
-#include "mainwindow.h"
-#include "variable.h"
+#include "iconformat.h"
+#include "memoryusage.h"
+#include "packbits.h"
+#include "trace.h"
 #include <QBuffer>
-#include <QFile>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QHash>
+#include <QSaveFile>
 #include <QDebug>
 
 /**
  * @brief IconWriter::write
  * @param filename
  * @param pixmaps
+ * @return
  */
-void IconWriter::write( const QString &filename, const QList<Layer*> pixmaps ) {
-    QFile file( filename );
+bool IconWriter::write( const QString &filename, const QList<Layer*> pixmaps, ExportReport *report ) const {
+    QSaveFile file( filename );
+
+    // write into a temporary file, replacing the original only on success
+    if ( !file.open( QIODevice::WriteOnly ))
+        return false;
 
-    // open icon file for writing
-    if ( file.open( QIODevice::WriteOnly )) {
-        QDataStream out( &file );
+    if ( !this->write( &file, pixmaps, report )) {
+        file.cancelWriting();
+        return false;
+    }
 
-        if ( Variable::instance()->isEnabled( "settings/macOS" )) {
-            out.setByteOrder( QDataStream::BigEndian );
+    return file.commit();
+}
 
-            QByteArray pixmapData;
-            QBuffer pixmapBuffer( &pixmapData );
-            pixmapBuffer.open( QIODevice::WriteOnly );
-            QDataStream pixmapSteam( &pixmapBuffer );
-            pixmapSteam.setByteOrder( QDataStream::BigEndian );
+/**
+ * @brief IconWriter::write streams an icon into an open device
+ * @param device
+ * @param pixmaps
+ * @param report optional per-entry size and timing report
+ * @return
+ *
+ * Seekable devices get a placeholder directory (or length) that is patched
+ * afterwards and hold only one encoded entry in memory at a time.
+ *
+ * Sequential devices (pipes, stdout, sockets) need the directory computed up
+ * front. Every entry is still encoded only once, so compact entries are kept
+ * from the sizing pass: png and palette entries of an ico, and the whole icns
+ * (which has nothing but png and rle entries). 32-bit ico bitmaps are sized
+ * analytically and streamed one at a time.
+ */
+bool IconWriter::write( QIODevice *device, const QList<Layer*> pixmaps, ExportReport *report ) const {
+    const TraceScope trace( "IconWriter::write" );
+    QElapsedTimer timer;
+    bool result;
+
+    if ( device == nullptr || !device->isWritable())
+        return false;
+
+    if ( report != nullptr ) {
+        *report = ExportReport();
+        report->format = this->m_options.macOS ? "icns" : "ico";
+    }
+
+    timer.start();
+    const qint64 start = device->isSequential() ? 0 : device->pos();
+    if ( this->m_options.macOS )
+        result = this->writeIcns( device, pixmaps, this->m_options.legacy, report );
+    else
+        result = this->writeIco( device, pixmaps, report );
+
+    if ( report != nullptr ) {
+        report->nanoseconds = timer.nsecsElapsed();
+        if ( !device->isSequential())
+            report->bytes = device->pos() - start;
+    }
+
+    return result;
+}
+
+/**
+ * @brief ExportEntry::toJson
+ * @return
+ */
+QJsonObject ExportEntry::toJson() const {
+    QJsonObject object;
+
+    object["scale"] = this->scale;
+    object["doubleScale"] = this->doubleScale;
+    object["representation"] = this->representation;
+    object["bytes"] = static_cast<double>( this->bytes );
+    object["rawBytes"] = static_cast<double>( this->rawBytes );
+    object["ratio"] = this->ratio();
+    object["milliseconds"] = static_cast<double>( this->nanoseconds ) / 1000000.0;
+
+    return object;
+}
+
+/**
+ * @brief ExportReport::entry finds the entry written for a layer
+ * @param scale
+ * @param doubleScale
+ * @return entry or nullptr
+ */
+const ExportEntry *ExportReport::entry( int scale, bool doubleScale ) const {
+    foreach ( const ExportEntry &entry, this->entries ) {
+        if ( entry.scale == scale && entry.doubleScale == doubleScale )
+            return &entry;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief ExportReport::toJson
+ * @return
+ */
+QJsonObject ExportReport::toJson() const {
+    QJsonObject object;
+    QJsonArray array;
 
-            int y = 0;
-            foreach ( Layer *layer, pixmaps ) {
-                const QImage image( layer->pixmap.toImage().convertToFormat( QImage::Format_ARGB32 ));
+    foreach ( const ExportEntry &entry, this->entries )
+        array << entry.toJson();
 
-                QByteArray bytes;
-                QBuffer buffer( &bytes );
-                buffer.open( QIODevice::WriteOnly );
-                image.save( &buffer, "PNG" );
-                buffer.close();
+    object["format"] = this->format;
+    object["bytes"] = static_cast<double>( this->bytes );
+    object["milliseconds"] = static_cast<double>( this->nanoseconds ) / 1000000.0;
+    object["entries"] = array;
 
-                pixmapSteam.writeRawData( Ui::macOSLayers.at( y ).code.toUtf8().constData(), 4 );
-                pixmapSteam << static_cast<quint32>( bytes.size() + 8 );
-                pixmapSteam.writeRawData( bytes, static_cast<int>( bytes.length()));
+    return object;
+}
 
-                y++;
+/**
+ * @brief IconWriter::writeIco
+ * @param device
+ * @param pixmaps
+ * @return
+ */
+bool IconWriter::writeIco( QIODevice *device, const QList<Layer*> pixmaps, ExportReport *report ) const {
+    QDataStream out( device );
+    IcoHeader header( static_cast<quint16>( pixmaps.count()));
+    QList<IcoDirectory> dirs;
+    const qint64 start = device->isSequential() ? 0 : device->pos();
+    qint64 offset = static_cast<qint64>( sizeof( IcoHeader ) + sizeof( IcoDirectory ) * static_cast<size_t>( pixmaps.count()));
+
+    out.setByteOrder( QDataStream::LittleEndian );
+
+    // write icon header
+    out << header;
+
+    if ( device->isSequential()) {
+        QList<QByteArray> encoded;
+        QList<qint64> times;
+        MemoryReservation kept;
+
+        // compute directory entries up front, keeping compact entries encoded for
+        // the sizing (32-bit bitmap sizes are analytic, so they are encoded while streaming)
+        foreach ( Layer *layer, pixmaps ) {
+            const bool shared = layer->isCompressed() && !layer->payload().isEmpty();
+            IcoDirectory dir;
+            QByteArray bytes;
+            QElapsedTimer timer;
+
+            timer.start();
+            if ( shared || layer->encoding() == Layer::Encodings::Bitmap ) {
+                dir = this->iconDirectory( layer );
+            } else {
+                bytes = this->iconData( layer->image(), layer->encoding(), &dir );
+                kept.add( bytes.size());
             }
 
-            pixmapBuffer.close();
+            dir.offset = static_cast<quint32>( offset );
+            offset += dir.bytes;
+            dirs << dir;
+            encoded << bytes;
+            times << timer.nsecsElapsed();
+        }
 
-            out << static_cast<quint8>( 0x69 );
-            out << static_cast<quint8>( 0x63 );
-            out << static_cast<quint8>( 0x6e );
-            out << static_cast<quint8>( 0x73 );
-            out << static_cast<quint32>( pixmapData.size() + 8 );
-            out.writeRawData( pixmapData.constData(), static_cast<int>( pixmapData.size()));
+        foreach ( const IcoDirectory &dir, dirs )
+            out << dir;
 
-        } else {
-            out.setByteOrder( QDataStream::LittleEndian );
+        // sequential devices cannot report their position, the directory knows the total
+        if ( report != nullptr )
+            report->bytes = offset;
 
-            IcoHeader header( static_cast<quint16>( pixmaps.count()));
-            QPixmap pixmap;
-            QList<IcoDirectory> dirs;
-            int y;
+        // write icon data
+        for ( int y = 0; y < pixmaps.count(); y++ ) {
+            this->writeIconData( pixmaps.at( y ), out, dirs.at( y ).offset, report, encoded.at( y ), times.at( y ));
+            encoded[y].clear();
+            if ( !this->report( y + 1, pixmaps.count()))
+                return false;
+        }
+    } else {
+        // skip to icon entries
+        for ( int y = 0; y < static_cast<int>( sizeof( IcoDirectory )) * pixmaps.count(); y++ )
+            out << static_cast<qint8>( 0 );
+
+        // write icon data
+        for ( int y = 0; y < pixmaps.count(); y++ ) {
+            dirs << this->writeIconData( pixmaps.at( y ), out, device->pos() - start, report );
+            if ( !this->report( y + 1, pixmaps.count()))
+                return false;
+        }
 
-            // write icon header
-            out << header;
+        // write icon directory entries
+        const qint64 end = device->pos();
+        device->seek( start + static_cast<qint64>( sizeof( IcoHeader )));
+        foreach ( const IcoDirectory &dir, dirs )
+            out << dir;
+        device->seek( end );
+    }
 
-            // skip to icon entries
-            for ( y = 0; y < static_cast<int>( sizeof( IcoDirectory )) * pixmaps.count(); y++ )
-                out << static_cast<qint8>( 0 );
+    return out.status() == QDataStream::Ok;
+}
 
-            // write icon data
-            foreach ( Layer *layer, pixmaps )
-                dirs << this->writeIconData( layer, out, file.pos());
+/**
+ * @brief IconWriter::writeIcns
+ * @param device
+ * @param pixmaps
+ * @param legacy
+ * @return
+ */
+bool IconWriter::writeIcns( QIODevice *device, const QList<Layer*> pixmaps, bool legacy, ExportReport *report ) const {
+    // total length goes first; sequential devices get the file assembled (and patched) in
+    // memory rather than a second encoding pass (icns entries are all compressed)
+    if ( device->isSequential()) {
+        QBuffer buffer;
+
+        buffer.open( QIODevice::WriteOnly );
+        if ( !this->writeIcns( &buffer, pixmaps, legacy, report ))
+            return false;
+
+        if ( report != nullptr )
+            report->bytes = buffer.size();
+
+        return device->write( buffer.data()) == buffer.size();
+    }
+
+    QDataStream out( device );
+    QHash<QByteArray, QByteArray> payloads;
+    QHash<QByteArray, int> uses;
+    QList<QByteArray> hashes;
+    const qint64 start = device->pos();
+    quint32 length = 8;
+
+    out.setByteOrder( QDataStream::BigEndian );
+
+    // pixel-identical layers (e.g. icp5 and ic11) share one png, kept only until its last use
+    foreach ( const Layer *layer, pixmaps ) {
+        const QByteArray hash( IconWriter::imageHash( layer->image().convertToFormat( QImage::Format_ARGB32 )));
+
+        hashes << hash;
+        uses[hash]++;
+    }
 
-            // write icon directory entries
-            file.seek( static_cast<int>( sizeof( IcoHeader )));
-            foreach ( const IcoDirectory &dir, dirs )
-                out << dir;
+    out.writeRawData( "icns", 4 );
+    out << length;
+
+    for ( int y = 0; y < pixmaps.count(); y++ ) {
+        const Layer *layer( pixmaps.at( y ));
+        QElapsedTimer timer;
+
+        timer.start();
+        const QByteArray bytes( this->icnsData( layer, legacy, &payloads ));
+        if ( --uses[hashes.at( y )] == 0 )
+            payloads.remove( hashes.at( y ));
+
+        // legacy records start with their own type code
+        if ( report != nullptr && !bytes.isEmpty()) {
+            ExportEntry entry( layer->scale(), layer->isDoubleScale());
+
+            entry.representation = bytes.left( 4 ) == IconFormat::macOSCode( layer->scale(), layer->isDoubleScale()).toLatin1() ? "PNG" : "RLE";
+            entry.bytes = bytes.size();
+            entry.rawBytes = static_cast<qint64>( layer->image().width()) * layer->image().height() * 4;
+            entry.nanoseconds = timer.nsecsElapsed();
+            report->entries << entry;
         }
 
-        // close file
-        file.close();
+        out.writeRawData( bytes.constData(), static_cast<int>( bytes.length()));
+        length += static_cast<quint32>( bytes.size());
+
+        if ( !this->report( y + 1, pixmaps.count()))
+            return false;
     }
+
+    // patch total length
+    const qint64 end = device->pos();
+    device->seek( start + 4 );
+    out << length;
+    device->seek( end );
+
+    return out.status() == QDataStream::Ok;
+}
+
+/**
+ * @brief IconWriter::legacyData encodes an image as per-channel PackBits RLE
+ * @param image
+ * @param prefix it32 entries start with four zero bytes
+ * @return
+ */
+QByteArray IconWriter::legacyData( const QImage &source, bool prefix ) {
+    const QImage image( source.convertToFormat( QImage::Format_ARGB32 ));
+    const int pixels = image.width() * image.height();
+    QByteArray channels[3];
+    QByteArray bytes;
+    int y, x, k;
+
+    // split into planar red, green and blue channels
+    for ( k = 0; k < 3; k++ )
+        channels[k].resize( pixels );
+
+    for ( y = 0; y < image.height(); y++ ) {
+        const QRgb *line = reinterpret_cast<const QRgb*>( image.constScanLine( y ));
+
+        for ( x = 0; x < image.width(); x++ ) {
+            channels[0][y * image.width() + x] = static_cast<char>( qRed( line[x] ));
+            channels[1][y * image.width() + x] = static_cast<char>( qGreen( line[x] ));
+            channels[2][y * image.width() + x] = static_cast<char>( qBlue( line[x] ));
+        }
+    }
+
+    if ( prefix )
+        bytes.append( 4, '\0' );
+
+    for ( k = 0; k < 3; k++ )
+        PackBits::encode( bytes, reinterpret_cast<const uchar*>( channels[k].constData()), pixels );
+
+    return bytes;
+}
+
+/**
+ * @brief IconWriter::imageHash returns a digest of image dimensions and pixels
+ * @param image
+ * @return
+ */
+QByteArray IconWriter::imageHash( const QImage &source ) {
+    const QImage image( source.convertToFormat( QImage::Format_ARGB32 ));
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+    const qint32 size[2] = { image.width(), image.height() };
+
+    hash.addData( reinterpret_cast<const char*>( size ), sizeof( size ));
+    hash.addData( reinterpret_cast<const char*>( image.constBits()), image.bytesPerLine() * image.height());
+
+    return hash.result();
+}
+
+/**
+ * @brief IconWriter::icnsData returns icns record(s) for a layer
+ * @param layer
+ * @param legacy allow RLE + mask records where they are smaller than png
+ * @param payloads optional png cache shared between pixel-identical layers
+ * @return
+ */
+QByteArray IconWriter::icnsData( const Layer *layer, bool legacy, QHash<QByteArray, QByteArray> *payloads ) const {
+    const TraceScope trace( "IconWriter::icnsData" );
+    const QString code( IconFormat::macOSCode( layer->scale(), layer->isDoubleScale()));
+    QByteArray bytes;
+    QByteArray png;
+    QByteArray hash;
+    QDataStream out( &bytes, QIODevice::WriteOnly );
+
+    if ( code.isEmpty())
+        return bytes;
+
+    const QImage image( layer->image().convertToFormat( QImage::Format_ARGB32 ));
+    MemoryReservation transient( MemoryUsage::imageBytes( image ));
+    out.setByteOrder( QDataStream::BigEndian );
+
+    // reuse png payload of a pixel-identical layer (e.g. icp5 and ic11)
+    if ( payloads != nullptr ) {
+        hash = IconWriter::imageHash( image );
+        png = payloads->value( hash );
+    }
+
+    // payload shared by a multi-target export
+    if ( png.isEmpty())
+        png = layer->payload();
+
+    // modern png entry
+    if ( png.isEmpty()) {
+        png = IconWriter::pngData( image );
+        transient.add( png.size());
+
+        if ( payloads != nullptr )
+            payloads->insert( hash, png );
+    }
+
+    // legacy rle entry with 8-bit mask
+    if ( legacy && !layer->isDoubleScale()) {
+        foreach ( const IconFormat::macOSLegacyLayer &type, IconFormat::macOSLegacyLayers ) {
+            if ( type.scale != layer->scale() || image.width() != type.scale || image.height() != type.scale )
+                continue;
+
+            const QByteArray rle( IconWriter::legacyData( image, type.code == "it32" ));
+            QByteArray mask( image.width() * image.height(), 0 );
+            const MemoryReservation legacyData( rle.size() + mask.size());
+
+            if ( rle.size() + mask.size() + 16 >= png.size() + 8 )
+                break;
+
+            for ( int y = 0; y < image.height(); y++ ) {
+                const QRgb *line = reinterpret_cast<const QRgb*>( image.constScanLine( y ));
+
+                for ( int x = 0; x < image.width(); x++ )
+                    mask[y * image.width() + x] = static_cast<char>( qAlpha( line[x] ));
+            }
+
+            out.writeRawData( type.code.toLatin1().constData(), 4 );
+            out << static_cast<quint32>( rle.size() + 8 );
+            out.writeRawData( rle.constData(), rle.size());
+
+            out.writeRawData( type.maskCode.toLatin1().constData(), 4 );
+            out << static_cast<quint32>( mask.size() + 8 );
+            out.writeRawData( mask.constData(), mask.size());
+
+            return bytes;
+        }
+    }
+
+    out.writeRawData( code.toLatin1().constData(), 4 );
+    out << static_cast<quint32>( png.size() + 8 );
+    out.writeRawData( png.constData(), png.size());
+
+    return bytes;
 }
 
 /**
@@ -108,7 +448,7 @@ void IconWriter::write( const QString &filename, const QList<Layer*> pixmaps ) {
  * @param out
  * @param pixmap
  */
-void IconWriter::writeData( QDataStream &out, const QImage &image, int bytesPerRow ) {
+void IconWriter::writeData( QDataStream &out, const QImage &image, int bytesPerRow ) const {
     int y, x;
 
     for ( y = 0; y < image.height(); y++ ) {
@@ -126,6 +466,51 @@ void IconWriter::writeData( QDataStream &out, const QImage &image, int bytesPerR
     }
 
     // write mask
+    this->writeMask( out, image, bytesPerRow );
+}
+
+/**
+ * @brief IconWriter::writePaletteData
+ * @param out
+ * @param image
+ * @param indexed
+ * @param bytesPerRow
+ */
+void IconWriter::writePaletteData( QDataStream &out, const QImage &image, const QImage &indexed, int bytesPerRow ) const {
+    const int indexBytesPerRow = ( indexed.width() + 3 ) & ~3;
+    QByteArray row( indexBytesPerRow, 0 );
+    int y;
+
+    // write colour table (BGR0)
+    foreach ( const QRgb colour, indexed.colorTable()) {
+        const char entry[4] = {
+            static_cast<char>( qBlue( colour )),
+            static_cast<char>( qGreen( colour )),
+            static_cast<char>( qRed( colour )),
+            0
+        };
+        out.writeRawData( entry, 4 );
+    }
+
+    // write indexes bottom-up, rows padded to 4 bytes
+    for ( y = 0; y < indexed.height(); y++ ) {
+        memcpy( row.data(), indexed.constScanLine( indexed.height() - y - 1 ), static_cast<size_t>( indexed.width()));
+        out.writeRawData( row.constData(), indexBytesPerRow );
+    }
+
+    // write mask
+    this->writeMask( out, image, bytesPerRow );
+}
+
+/**
+ * @brief IconWriter::writeMask
+ * @param out
+ * @param image
+ * @param bytesPerRow
+ */
+void IconWriter::writeMask( QDataStream &out, const QImage &image, int bytesPerRow ) const {
+    int y, x;
+
     for ( y = 0; y < image.height(); y++ ) {
         unsigned char *data = new unsigned char[static_cast<unsigned long long>( bytesPerRow )];
 
@@ -136,7 +521,7 @@ void IconWriter::writeData( QDataStream &out, const QImage &image, int bytesPerR
             const int bytePos = x % 8 ? ( x + 7 ) / 8 - 1 : x / 8;
             const int bitPos = 7 - x % 8;
 
-            if ( !image.pixelColor( x, image.height() - y - 1 ).alpha())
+            if ( image.pixelColor( x, image.height() - y - 1 ).alpha() < IconFormat::AlphaThreshold )
                 data[bytePos] |= 1UL << bitPos;
 
             x++;
@@ -148,44 +533,289 @@ void IconWriter::writeData( QDataStream &out, const QImage &image, int bytesPerR
 }
 
 /**
- * @brief IconWriter::getIconData
- * @param pixmap
+ * @brief IconWriter::toPalette converts image to an 8-bit indexed image
+ * @param image
+ * @param exact set to false if colours had to be quantized
  * @return
+ *
+ * Transparent pixels are always mapped to a black entry, so that they
+ * compose cleanly with the AND mask.
  */
-IcoDirectory IconWriter::writeIconData( Layer *layer, QDataStream &out, qint64 pos ) {
-    const QImage image( layer->pixmap.toImage().convertToFormat( QImage::Format_ARGB32 ));
-    BitmapHeader header;
-    quint32 imageSize = 0;
+QImage IconWriter::toPalette( const QImage &image, bool *exact ) {
+    const QImage source( image.convertToFormat( QImage::Format_ARGB32 ));
+    QVector<QRgb> colours;
+    QHash<QRgb, int> indexes;
+    bool lossless = true;
+    int y, x;
+
+    // reserve black for transparent pixels
+    colours << qRgb( 0, 0, 0 );
+    indexes[qRgb( 0, 0, 0 )] = 0;
+
+    // try an exact palette first (binary alpha, at most 256 colours)
+    for ( y = 0; y < source.height() && lossless; y++ ) {
+        const QRgb *line = reinterpret_cast<const QRgb*>( source.constScanLine( y ));
+
+        for ( x = 0; x < source.width(); x++ ) {
+            const int alpha = qAlpha( line[x] );
+            const QRgb colour( line[x] | 0xff000000 );
+
+            if ( alpha == 0 )
+                continue;
+
+            if ( alpha != 255 || ( !indexes.contains( colour ) && colours.count() == 256 )) {
+                lossless = false;
+                break;
+            }
+
+            if ( !indexes.contains( colour )) {
+                indexes[colour] = colours.count();
+                colours << colour;
+            }
+        }
+    }
+
+    if ( exact != nullptr )
+        *exact = lossless;
+
+    if ( lossless ) {
+        QImage indexed( source.size(), QImage::Format_Indexed8 );
+
+        indexed.setColorTable( colours );
+        for ( y = 0; y < source.height(); y++ ) {
+            const QRgb *line = reinterpret_cast<const QRgb*>( source.constScanLine( y ));
+            uchar *out = indexed.scanLine( y );
+
+            for ( x = 0; x < source.width(); x++ )
+                out[x] = static_cast<uchar>( qAlpha( line[x] ) ? indexes[line[x] | 0xff000000] : 0 );
+        }
+
+        return indexed;
+    }
+
+    // quantize, masking out translucent pixels
+    QImage opaque( source.convertToFormat( QImage::Format_RGB32 ));
+    for ( y = 0; y < source.height(); y++ ) {
+        const QRgb *line = reinterpret_cast<const QRgb*>( source.constScanLine( y ));
+        QRgb *out = reinterpret_cast<QRgb*>( opaque.scanLine( y ));
+
+        for ( x = 0; x < source.width(); x++ ) {
+            if ( qAlpha( line[x] ) < IconFormat::AlphaThreshold )
+                out[x] = qRgb( 0, 0, 0 );
+        }
+    }
+
+    QImage indexed( opaque.convertToFormat( QImage::Format_Indexed8, Qt::DiffuseDither ));
+    QVector<QRgb> table( indexed.colorTable());
+    int black = 0;
+
+    // snap the darkest entry to pure black
+    for ( y = 1; y < table.count(); y++ ) {
+        if ( qGray( table.at( y )) < qGray( table.at( black )))
+            black = y;
+    }
+    if ( !table.isEmpty()) {
+        table[black] = qRgb( 0, 0, 0 );
+        indexed.setColorTable( table );
+    }
+
+    for ( y = 0; y < source.height(); y++ ) {
+        const QRgb *line = reinterpret_cast<const QRgb*>( source.constScanLine( y ));
+        uchar *out = indexed.scanLine( y );
+
+        for ( x = 0; x < source.width(); x++ ) {
+            if ( qAlpha( line[x] ) < IconFormat::AlphaThreshold )
+                out[x] = static_cast<uchar>( black );
+        }
+    }
+
+    return indexed;
+}
+
+/**
+ * @brief IconWriter::bitmapSize returns size of a BMP icon entry
+ * @param width
+ * @param height
+ * @param colours palette size (0 for 32-bit entries)
+ * @return
+ */
+qint64 IconWriter::bitmapSize( int width, int height, int colours ) {
+    const qint64 mask = static_cast<qint64>( IconWriter::maskBytesPerRow( width )) * height;
+
+    if ( colours > 0 )
+        return static_cast<qint64>( sizeof( BitmapHeader )) + colours * 4 + static_cast<qint64>(( width + 3 ) & ~3 ) * height + mask;
+
+    return static_cast<qint64>( sizeof( BitmapHeader )) + static_cast<qint64>( width ) * height * 4 + mask;
+}
+
+/**
+ * @brief IconWriter::iconDirectory computes a directory entry without keeping the encoded data
+ * @param image
+ * @param encoding
+ * @return
+ */
+IcoDirectory IconWriter::iconDirectory( const QImage &image, Layer::Encodings encoding ) const {
     IcoDirectory dir;
-    const int bytesPerRow = image.width() % 32 ? ( image.width() / 32 + 1 ) * 4 : image.width() / 8;
 
-    if ( !layer->isCompressed()) {
+    // only png sizes are unknown until encoded
+    if ( encoding == Layer::Encodings::PNG ) {
+        this->iconData( image, encoding, &dir );
+        return dir;
+    }
+
+    const int colours = encoding == Layer::Encodings::Palette ? IconWriter::toPalette( image ).colorCount() : 0;
+    dir.width = image.width() >= IconFormat::ThresholdScale ? 0 : static_cast<quint8>( image.width());
+    dir.height = image.height() >= IconFormat::ThresholdScale ? 0 : static_cast<quint8>( image.height());
+    dir.numColours = colours >= 256 ? 0 : static_cast<quint8>( colours );
+    dir.depth = encoding == Layer::Encodings::Palette ? 8 : 32;
+    dir.bytes = static_cast<quint32>( IconWriter::bitmapSize( image.width(), image.height(), colours ));
+
+    return dir;
+}
+
+/**
+ * @brief IconWriter::iconDirectory computes a directory entry for a layer, using its png payload if set
+ * @param layer
+ * @return
+ */
+IcoDirectory IconWriter::iconDirectory( const Layer *layer ) const {
+    IcoDirectory dir;
+
+    if ( !layer->isCompressed() || layer->payload().isEmpty())
+        return this->iconDirectory( layer->image(), layer->encoding());
+
+    dir.width = layer->image().width() >= IconFormat::ThresholdScale ? 0 : static_cast<quint8>( layer->image().width());
+    dir.height = layer->image().height() >= IconFormat::ThresholdScale ? 0 : static_cast<quint8>( layer->image().height());
+    dir.bytes = static_cast<quint32>( layer->payload().size());
+
+    return dir;
+}
+
+/**
+ * @brief IconWriter::pngData encodes an image as png (same bytes for ico and icns entries)
+ * @param image
+ * @return
+ */
+QByteArray IconWriter::pngData( const QImage &image ) {
+    const TraceScope trace( "PNG encode" );
+    QByteArray bytes;
+    QBuffer buffer( &bytes );
+
+    buffer.open( QIODevice::WriteOnly );
+    image.convertToFormat( QImage::Format_ARGB32 ).save( &buffer, "PNG" );
+    buffer.close();
+
+    return bytes;
+}
+
+/**
+ * @brief IconWriter::iconData encodes a single ico entry
+ * @param image
+ * @param encoding
+ * @param dir optional directory entry to fill (offset is left untouched)
+ * @return
+ */
+QByteArray IconWriter::iconData( const QImage &source, Layer::Encodings encoding, IcoDirectory *dir ) const {
+    const TraceScope trace( "IconWriter::iconData" );
+    QImage image;
+
+    {
+        const TraceScope convert( "QImage::convertToFormat" );
+        image = source.convertToFormat( QImage::Format_ARGB32 );
+    }
+    MemoryReservation transient( MemoryUsage::imageBytes( image ));
+
+    const int bytesPerRow = IconWriter::maskBytesPerRow( image.width());
+    QByteArray bytes;
+    QBuffer buffer( &bytes );
+    BitmapHeader header;
+    int colours = 0;
+
+    buffer.open( QIODevice::WriteOnly );
+
+    if ( encoding == Layer::Encodings::PNG ) {
+        buffer.write( IconWriter::pngData( image ));
+    } else {
+        QDataStream out( &buffer );
+        out.setByteOrder( QDataStream::LittleEndian );
+
         // generate header
         header.width = image.width();
         header.height = image.height() * 2;
-        header.imageSize = static_cast<quint32>( image.width() * image.height() * 4 + bytesPerRow * image.height());
         header.xpm = image.dotsPerMeterX();
         header.ypm = image.dotsPerMeterY();
 
-        // write header
-        out << header;
+        if ( encoding == Layer::Encodings::Palette ) {
+            const QImage indexed( IconWriter::toPalette( image ));
 
-        // write pixmap data
-        this->writeData( out, image, bytesPerRow );
-    } else {
-        QByteArray bytes;
-        QBuffer buffer( &bytes );
-        buffer.open( QIODevice::WriteOnly );
-        image.save( &buffer, "PNG" );
-        out.writeRawData( bytes, static_cast<int>( bytes.size()));
-        imageSize = static_cast<quint32>( bytes.size());
-        buffer.close();
+            colours = indexed.colorCount();
+            header.depth = 8;
+            header.numColors = static_cast<quint32>( colours );
+            header.imageSize = static_cast<quint32>( IconWriter::bitmapSize( image.width(), image.height(), colours ) - static_cast<qint64>( sizeof( BitmapHeader )) - colours * 4 );
+
+            out << header;
+            this->writePaletteData( out, image, indexed, bytesPerRow );
+        } else {
+            header.imageSize = static_cast<quint32>( image.width() * image.height() * 4 + bytesPerRow * image.height());
+
+            out << header;
+            this->writeData( out, image, bytesPerRow );
+        }
     }
+    buffer.close();
+    transient.add( bytes.size());
+
+    // generate ico directory (0 stands for 256 and above)
+    if ( dir != nullptr ) {
+        dir->width = image.width() >= IconFormat::ThresholdScale ? 0 : static_cast<quint8>( image.width());
+        dir->height = image.height() >= IconFormat::ThresholdScale ? 0 : static_cast<quint8>( image.height());
+        dir->numColours = colours >= 256 ? 0 : static_cast<quint8>( colours );
+        dir->depth = encoding == Layer::Encodings::Palette ? 8 : 32;
+        dir->bytes = static_cast<quint32>( bytes.size());
+    }
+
+    return bytes;
+}
+
+/**
+ * @brief IconWriter::writeIconData
+ * @param layer
+ * @param out
+ * @param pos
+ * @param report
+ * @param encoded entry already encoded by a sizing pass (the returned directory is then not filled)
+ * @param encodeTime time spent encoding it
+ * @return
+ */
+IcoDirectory IconWriter::writeIconData( Layer *layer, QDataStream &out, qint64 pos, ExportReport *report, const QByteArray &encoded, qint64 encodeTime ) const {
+    const TraceScope trace( "IconWriter::writeIconData" );
+    IcoDirectory dir;
+    QElapsedTimer timer;
+
+    timer.start();
+    const bool shared = layer->isCompressed() && !layer->payload().isEmpty();
+    QByteArray bytes( encoded );
+    if ( bytes.isEmpty()) {
+        bytes = shared ? layer->payload() : this->iconData( layer->image(), layer->encoding(), &dir );
+        if ( shared )
+            dir = this->iconDirectory( layer );
+    }
+
+    if ( report != nullptr ) {
+        ExportEntry entry( layer->scale(), layer->isDoubleScale());
 
-    // generate ico directory
-    dir.width = layer->isCompressed() ? 0 : static_cast<quint8>( header.width );
-    dir.height = layer->isCompressed() ? 0 : static_cast<quint8>( header.height / 2 );
-    dir.bytes = layer->isCompressed() ? imageSize : sizeof( BitmapHeader ) + header.imageSize;
+        entry.representation = layer->encoding() == Layer::Encodings::PNG ? "PNG" : layer->encoding() == Layer::Encodings::Palette ? "Palette" : "BMP";
+        entry.bytes = bytes.size();
+        entry.rawBytes = static_cast<qint64>( layer->image().width()) * layer->image().height() * 4;
+        entry.nanoseconds = timer.nsecsElapsed() + encodeTime;
+        report->entries << entry;
+    }
+    const MemoryReservation transient( encoded.isEmpty() ? bytes.size() : 0 );
+
+    {
+        const TraceScope io( "file I/O" );
+        out.writeRawData( bytes.constData(), static_cast<int>( bytes.size()));
+    }
     dir.offset = static_cast<quint32>( pos );
 
     // return directory entry
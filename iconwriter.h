@@ -22,9 +22,11 @@
 // includes
 //
 #include <QDataStream>
+#include <QHash>
+#include <QJsonObject>
 #include <QPixmap>
+#include <functional>
 #include "layer.h"
-#include "main.h"
 
 /**
  * @brief The IcoHeader struct
@@ -84,19 +86,80 @@ struct BitmapHeader {
 inline static QDataStream &operator<<( QDataStream &out, const BitmapHeader &b ) { out << b.headerSize << b.width << b.height << b.planes << b.depth << b.compression << b.imageSize << b.xpm << b.ypm << b.numColors << b.indexes; return out; }
 
 /**
- * @brief The IconWriter class
+ * @brief The WriterOptions struct
+ */
+struct WriterOptions {
+    bool macOS;
+    bool legacy;
+    WriterOptions( bool m = false, bool l = true ) : macOS( m ), legacy( l ) {}
+};
+
+/**
+ * @brief The ExportEntry struct describes a single written icon entry
  */
-class IconWriter final : public QObject {
-    Q_OBJECT
-    Q_DISABLE_COPY( IconWriter )
+struct ExportEntry {
+    int scale;
+    bool doubleScale;
+    QString representation;
+    qint64 bytes;
+    qint64 rawBytes;
+    qint64 nanoseconds;
+    ExportEntry( int s = 0, bool d = false ) : scale( s ), doubleScale( d ), bytes( 0 ), rawBytes( 0 ), nanoseconds( 0 ) {}
+    double ratio() const { return this->bytes > 0 ? static_cast<double>( this->rawBytes ) / this->bytes : 0.0; }
+    QJsonObject toJson() const;
+};
 
+/**
+ * @brief The ExportReport struct collects entries of a single write
+ */
+struct ExportReport {
+    QString format;
+    QList<ExportEntry> entries;
+    qint64 bytes = 0;
+    qint64 nanoseconds = 0;
+    const ExportEntry *entry( int scale, bool doubleScale ) const;
+    QJsonObject toJson() const;
+};
+
+/**
+ * @brief The IconWriter class
+ *
+ * Writers hold nothing but their options, so any number of them can
+ * encode concurrently.
+ */
+class IconWriter final {
 public:
-    static IconWriter *instance() { static IconWriter *instance = new IconWriter(); return instance; }
-    virtual ~IconWriter() = default;
-    void write( const QString &filename, const QList<Layer*> pixmaps );
+    /**
+     * @brief Progress is called after every entry with (written, total), returning false cancels
+     */
+    typedef std::function<bool( int, int )> Progress;
+
+    explicit IconWriter( const WriterOptions &options = WriterOptions()) : m_options( options ) {}
+    ~IconWriter() = default;
+    const WriterOptions &options() const { return this->m_options; }
+    void setOptions( const WriterOptions &options ) { this->m_options = options; }
+    void setProgress( const Progress &progress ) { this->m_progress = progress; }
+    bool write( const QString &filename, const QList<Layer*> pixmaps, ExportReport *report = nullptr ) const;
+    bool write( QIODevice *device, const QList<Layer*> pixmaps, ExportReport *report = nullptr ) const;
+    QByteArray iconData( const QImage &image, Layer::Encodings encoding, IcoDirectory *dir = nullptr ) const;
+    IcoDirectory iconDirectory( const QImage &image, Layer::Encodings encoding ) const;
+    IcoDirectory iconDirectory( const Layer *layer ) const;
+    QByteArray icnsData( const Layer *layer, bool legacy = false, QHash<QByteArray, QByteArray> *payloads = nullptr ) const;
+    static QByteArray imageHash( const QImage &image );
+    static QByteArray pngData( const QImage &image );
+    static QByteArray legacyData( const QImage &image, bool prefix = false );
+    static QImage toPalette( const QImage &image, bool *exact = nullptr );
+    static int maskBytesPerRow( int width ) { return width % 32 ? ( width / 32 + 1 ) * 4 : width / 8; }
+    static qint64 bitmapSize( int width, int height, int colours = 0 );
 
 private:
-    IcoDirectory writeIconData( Layer *layer, QDataStream &out, qint64 pos );
-    void writeData( QDataStream &out, const QImage &image, int bytesPerRow );
-    IconWriter() { GarbageMan::instance()->add( this ); }
+    bool writeIco( QIODevice *device, const QList<Layer*> pixmaps, ExportReport *report ) const;
+    bool writeIcns( QIODevice *device, const QList<Layer*> pixmaps, bool legacy, ExportReport *report ) const;
+    IcoDirectory writeIconData( Layer *layer, QDataStream &out, qint64 pos, ExportReport *report, const QByteArray &encoded = QByteArray(), qint64 encodeTime = 0 ) const;
+    void writeData( QDataStream &out, const QImage &image, int bytesPerRow ) const;
+    void writePaletteData( QDataStream &out, const QImage &image, const QImage &indexed, int bytesPerRow ) const;
+    void writeMask( QDataStream &out, const QImage &image, int bytesPerRow ) const;
+    bool report( int written, int total ) const { return !this->m_progress || this->m_progress( written, total ); }
+    WriterOptions m_options;
+    Progress m_progress;
 };
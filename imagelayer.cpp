@@ -46,3 +46,15 @@ ImageLayer::ImageLayer( QGraphicsScene *scene, const QPixmap &pixmap ) :
 QGraphicsItem *ImageLayer::item() {
     return dynamic_cast<QGraphicsItem*>( this->pixmapItem );
 }
+
+/**
+ * @brief ImageLayer::pixelBytes
+ * @return bytes held by the item pixmap
+ */
+qint64 ImageLayer::pixelBytes() const {
+    if ( this->pixmapItem == nullptr || this->pixmapItem->pixmap().isNull())
+        return 0;
+
+    const QPixmap pixmap( this->pixmapItem->pixmap());
+    return static_cast<qint64>( pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
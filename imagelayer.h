@@ -34,6 +34,7 @@ class ImageLayer final : public DesignerLayer {
 public:
     ImageLayer( QGraphicsScene *scene = nullptr, const QPixmap &pixmap = QPixmap());
     QGraphicsItem *item() override;
+    qint64 pixelBytes() const override;
 
 private:
     QGraphicsPixmapItem *pixmapItem;
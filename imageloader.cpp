@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+//
+// includes
+//
+#include "imageloader.h"
+#include "iconsource.h"
+#include <QApplication>
+#include <QtConcurrent>
+
+/**
+ * @brief ImageLoader::ImageLoader
+ * @param parent
+ */
+ImageLoader::ImageLoader( QObject *parent ) : QObject( parent ), watcher( new QFutureWatcher<QImage>( this )), busy( false ) {
+    this->connect( this->watcher, &QFutureWatcher<QImage>::finished, this, &ImageLoader::finished );
+}
+
+/**
+ * @brief ImageLoader::~ImageLoader
+ */
+ImageLoader::~ImageLoader() {
+    this->watcher->disconnect();
+    this->watcher->waitForFinished();
+
+    if ( this->busy )
+        QApplication::restoreOverrideCursor();
+}
+
+/**
+ * @brief ImageLoader::load starts decoding, superseding any load in flight
+ * @param fileName
+ * @param ready called on the GUI thread with the image (null on failure)
+ * @param svgScale
+ *
+ * A superseded decode is not interrupted (QImageReader cannot be cancelled),
+ * it runs to completion on its worker and the result is discarded; a large
+ * svg rendered at full scale keeps a pool thread busy meanwhile.
+ */
+void ImageLoader::load( const QString &fileName, const Callback &ready, int svgScale ) {
+    this->ready = ready;
+
+    // show busy indicator until the latest request arrives
+    if ( !this->busy ) {
+        QApplication::setOverrideCursor( Qt::BusyCursor );
+        this->busy = true;
+    }
+
+    // a watcher reports only its current future, so older results are dropped
+    this->watcher->setFuture( QtConcurrent::run( IconSource::decode, fileName, svgScale ));
+}
+
+/**
+ * @brief ImageLoader::finished delivers the result of the latest request
+ */
+void ImageLoader::finished() {
+    const Callback ready( this->ready );
+
+    this->ready = nullptr;
+    if ( this->busy ) {
+        QApplication::restoreOverrideCursor();
+        this->busy = false;
+    }
+
+    if ( ready )
+        ready( this->watcher->result());
+}
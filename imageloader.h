@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+#pragma once
+
+//
+// includes
+//
+#include <QFutureWatcher>
+#include <QImage>
+#include <QObject>
+#include <functional>
+#include "iconformat.h"
+
+/**
+ * @brief The ImageLoader class decodes images on a worker thread
+ *
+ * Only the most recent request is delivered; starting a new load
+ * supersedes the one in flight.
+ */
+class ImageLoader final : public QObject {
+    Q_OBJECT
+    Q_DISABLE_COPY( ImageLoader )
+
+public:
+    typedef std::function<void( const QImage & )> Callback;
+
+    explicit ImageLoader( QObject *parent = nullptr );
+    ~ImageLoader();
+    void load( const QString &fileName, const Callback &ready, int svgScale = IconFormat::MaximumScale );
+    bool isLoading() const { return this->watcher->isRunning(); }
+
+private slots:
+    void finished();
+
+private:
+    QFutureWatcher<QImage> *watcher;
+    Callback ready;
+    bool busy;
+};
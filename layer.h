@@ -21,40 +21,120 @@
 //
 // includes
 //
+#include <QAtomicInteger>
+#include <QImage>
+#include <QMutex>
 #include <QPixmap>
+#include <QSharedPointer>
+#include <functional>
+#include "trace.h"
+
+/**
+ * @brief The LayerDecoder struct holds deferred image data shared by layer copies
+ *
+ * Copies of a layer (e.g. snapshots handed to workers) share one decoder, so
+ * the data is decoded once, under a lock, whichever thread asks first.
+ */
+struct LayerDecoder {
+    explicit LayerDecoder( const std::function<QImage()> &d ) : decode( d ) {}
+    QMutex mutex;
+    std::function<QImage()> decode;
+    QImage image;
+};
 
 /**
  * @brief The LayerModel class
  */
 class Layer final {
 public:
+    enum class Encodings {
+        NoEncoding = -1,
+        Bitmap,
+        PNG,
+        Palette
+    };
+
     /**
      * @brief Layer
      */
-    Layer( const QPixmap& px = QPixmap(), int scale = 0, bool compressed = false, bool doubleScale = false ) : m_scale( scale ), m_compressed( compressed ), m_override( false ), m_doubleScale( doubleScale ) {
-        if ( !px.isNull())
-            this->pixmap = px.scaled( scale, scale, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
-        else
+    Layer( const QImage& source = QImage(), int scale = 0, bool compressed = false, bool doubleScale = false ) : m_scale( scale ), m_encoding( compressed ? Encodings::PNG : Encodings::Bitmap ), m_override( false ), m_doubleScale( doubleScale ), m_plannedBytes( 0 ), m_storedBytes( 0 ), m_generation( Layer::nextGeneration()) {
+        if ( !source.isNull()) {
+            const TraceScope trace( "Layer::scale" );
+            this->m_image = source.scaled( scale, scale, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+        } else
             this->m_scale = 0;
     }
     Layer& operator=( const Layer & ) = default;
     Layer( const Layer& ) = default;
 
-    QPixmap pixmap;
+    /**
+     * @brief image returns layer image, decoding deferred data on first use
+     * @return
+     *
+     * Images (unlike pixmaps) can be used outside the GUI thread.
+     */
+    const QImage &image() const {
+        if ( this->m_decoder.isNull())
+            return this->m_image;
+
+        // decoded image is never modified afterwards, so it can be returned unlocked
+        QMutexLocker lock( &this->m_decoder->mutex );
+        if ( this->m_decoder->decode ) {
+            this->m_decoder->image = this->m_decoder->decode();
+            this->m_decoder->decode = nullptr;
+        }
+        return this->m_decoder->image;
+    }
+    QPixmap pixmap() const { return QPixmap::fromImage( this->image()); }
+    void setImage( const QImage &image ) { this->m_image = image; this->m_decoder.reset(); this->m_payload.clear(); this->m_storedBytes = 0; this->m_generation = Layer::nextGeneration(); }
+    void setDecoder( const std::function<QImage()> &decoder ) { this->m_image = QImage(); this->m_decoder.reset( new LayerDecoder( decoder )); this->m_payload.clear(); this->m_storedBytes = 0; this->m_generation = Layer::nextGeneration(); }
+    // size of the entry this layer was imported from (0 once pixels or encoding change)
+    qint64 storedBytes() const { return this->m_storedBytes; }
+    void setStoredBytes( qint64 bytes ) { this->m_storedBytes = bytes; }
+    // identifies pixel content, shared by copies and renewed whenever the image is replaced
+    quint64 generation() const { return this->m_generation; }
+    // optional pre-encoded png of image(), used by writers instead of encoding again
+    const QByteArray &payload() const { return this->m_payload; }
+    void setPayload( const QByteArray &payload ) { this->m_payload = payload; }
+    bool isDecoded() const {
+        if ( this->m_decoder.isNull())
+            return true;
+
+        QMutexLocker lock( &this->m_decoder->mutex );
+        return !this->m_decoder->decode;
+    }
     int scale() const { return this->m_scale; }
-    bool isCompressed() const { return this->m_compressed; }
+    bool isCompressed() const { return this->m_encoding == Encodings::PNG; }
+    Encodings encoding() const { return this->m_encoding; }
+    qint64 plannedBytes() const { return this->m_plannedBytes; }
     bool isOverriden() const { return this->m_override; }
     bool isDoubleScale() const { return this->m_doubleScale; }
     void setScale( int scale ) { this->m_scale = scale; }
-    void setCompressed( bool compressed ) { this->m_compressed = compressed; }
+    void setCompressed( bool compressed ) { this->setEncoding( compressed ? Encodings::PNG : Encodings::Bitmap ); }
+    void setEncoding( Encodings encoding, qint64 plannedBytes = 0 ) { if ( encoding != this->m_encoding ) this->m_storedBytes = 0; this->m_encoding = encoding; this->m_plannedBytes = plannedBytes; }
     void setOverriden( bool override = false ) { this->m_override = override; }
+    void setDoubleScale( bool doubleScale ) { this->m_doubleScale = doubleScale; }
     bool operator>( const Layer& layer ) const { return ( this->scale() > layer.scale()); }
     bool operator<( const Layer& layer ) const { return ( this->scale() < layer.scale()); }
     bool operator==( const Layer& layer ) const { return ( this->scale() == layer.scale()); }
 
 private:
+    /**
+     * @brief nextGeneration returns a process-wide unique pixel generation
+     * @return
+     */
+    static quint64 nextGeneration() {
+        static QAtomicInteger<quint64> counter( 0 );
+        return counter.fetchAndAddRelaxed( 1 ) + 1;
+    }
+    QImage m_image;
+    QSharedPointer<LayerDecoder> m_decoder;
+    QByteArray m_payload;
     int m_scale;
-    bool m_compressed;
+    Encodings m_encoding;
     bool m_override;
     bool m_doubleScale;
+    qint64 m_plannedBytes;
+    qint64 m_storedBytes;
+    quint64 m_generation;
 };
@@ -22,6 +22,7 @@
 #include "layer.h"
 #include "layermodel.h"
 #include "mainwindow.h"
+#include <QLocale>
 
 /**
  * @brief LayerModel::rowCount
@@ -46,12 +47,28 @@ QVariant LayerModel::data( const QModelIndex &index, int role ) const {
         return QVariant();
 
     if ( role == Qt::DisplayRole ) {
-        const int scale = MainWindow::instance()->layers.at( index.row())->scale();
-        const bool doubleScale = MainWindow::instance()->layers.at( index.row())->isDoubleScale();
+        const Layer *layer( MainWindow::instance()->layers.at( index.row()));
+        const int scale = layer->scale();
+        const QString name( layer->isDoubleScale() ? QString( "%1x%1@2x" ).arg( scale / 2 ) : QString( "%1x%1" ).arg( scale ));
 
-        return doubleScale ? QString( "%1x%1@2x" ).arg( scale / 2 ) : QString( "%1x%1" ).arg( scale );
+        // display written size, ratio and encode time of the last export
+        const ExportEntry *entry( MainWindow::instance()->lastExport().entry( layer->scale(), layer->isDoubleScale()));
+        if ( entry != nullptr )
+            return QString( "%1 (%2, %3, %4:1, %5 ms)" ).arg( name ).arg( entry->representation ).arg( QLocale().formattedDataSize( entry->bytes )).arg( entry->ratio(), 0, 'f', 1 ).arg( static_cast<double>( entry->nanoseconds ) / 1000000.0, 0, 'f', 1 );
+
+        // display planned encoding and size
+        if ( layer->plannedBytes() > 0 )
+            return QString( "%1 (%2, %3)" ).arg( name ).arg( LayerModel::encodingName( layer->encoding())).arg( QLocale().formattedDataSize( layer->plannedBytes()));
+
+        return name;
     } else if ( role == Qt::DecorationRole ) {
-        return MainWindow::instance()->layers.at( index.row())->pixmap.scaled( 16, 16, Qt::IgnoreAspectRatio, Qt::FastTransformation );
+        const Layer *layer( MainWindow::instance()->layers.at( index.row()));
+
+        // do not decode entries just to draw thumbnails
+        if ( !layer->isDecoded())
+            return QVariant();
+
+        return layer->image().scaled( 16, 16, Qt::IgnoreAspectRatio, Qt::FastTransformation );
     } else if ( role == ScaleRole ) {
         return MainWindow::instance()->layers.at( index.row())->scale();
     }
@@ -59,6 +76,29 @@ QVariant LayerModel::data( const QModelIndex &index, int role ) const {
     return QVariant();
 }
 
+/**
+ * @brief LayerModel::encodingName
+ * @param encoding
+ * @return
+ */
+QString LayerModel::encodingName( Layer::Encodings encoding ) {
+    switch ( encoding ) {
+    case Layer::Encodings::Bitmap:
+        return LayerModel::tr( "BMP" );
+
+    case Layer::Encodings::PNG:
+        return LayerModel::tr( "PNG" );
+
+    case Layer::Encodings::Palette:
+        return LayerModel::tr( "8-bit" );
+
+    case Layer::Encodings::NoEncoding:
+        break;
+    }
+
+    return QString();
+}
+
 /**
  * @brief LayerModel::resetModel
  * @param limit
@@ -23,6 +23,7 @@
 //
 #include <QAbstractListModel>
 #include <QPixmap>
+#include "layer.h"
 
 /**
  * @brief The LayerModel class
@@ -41,6 +42,7 @@ public:
     ~LayerModel() = default;
     int rowCount( const QModelIndex &parent = QModelIndex()) const override;
     QVariant data( const QModelIndex &index, int role = Qt::DisplayRole ) const override;
+    static QString encodingName( Layer::Encodings encoding );
 
 public slots:
     void resetModel();
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+//
+// includes
+//
+#include "layerset.h"
+#include "iconformat.h"
+
+/**
+ * @brief LayerSet::LayerSet builds mipmaps for the requested scales
+ * @param source
+ * @param options
+ */
+LayerSet::LayerSet( const IconSource &source, const LayerSetOptions &options ) {
+    if ( !source.isValid())
+        return;
+
+    if ( options.macOS ) {
+        foreach ( const IconFormat::macOSLayer &layer, IconFormat::macOSLayers )
+            this->m_layers << new Layer( source.image(), layer.scale, false, layer.doubleScale );
+    } else {
+        foreach ( const int scale, options.scales ) {
+            if ( scale >= IconFormat::MinimumScale && scale <= IconFormat::MaximumScale )
+                this->m_layers << new Layer( source.image(), scale, options.compress && scale >= options.threshold );
+        }
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+#pragma once
+
+//
+// includes
+//
+#include <QList>
+#include "iconformat.h"
+#include "iconsource.h"
+#include "layer.h"
+
+/**
+ * @brief The LayerSetOptions struct
+ */
+struct LayerSetOptions {
+    QList<int> scales;
+    bool macOS;
+    bool compress;
+    int threshold;
+    LayerSetOptions( const QList<int> &s = QList<int>(), bool m = false, bool c = true, int t = IconFormat::ThresholdScale ) : scales( s ), macOS( m ), compress( c ), threshold( t ) {}
+};
+
+/**
+ * @brief The LayerSet class owns the layers generated from a single source
+ */
+class LayerSet final {
+    Q_DISABLE_COPY( LayerSet )
+
+public:
+    LayerSet( const IconSource &source, const LayerSetOptions &options );
+    ~LayerSet() { qDeleteAll( this->m_layers ); }
+    const QList<Layer*> &layers() const { return this->m_layers; }
+    bool isEmpty() const { return this->m_layers.isEmpty(); }
+
+private:
+    QList<Layer*> m_layers;
+};
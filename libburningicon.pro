@@ -0,0 +1,57 @@
+#-------------------------------------------------
+#
+# Reentrant icon conversion core (no widgets)
+#
+# Conversions share no state. The only process-global state is thread-safe
+# and never changes output: diagnostics (Trace, MemoryUsage) and caches of
+# pure functions (glyph outlines, bezel fields).
+#
+#-------------------------------------------------
+
+QT       = core gui concurrent
+
+TARGET = burningicon
+TEMPLATE = lib
+CONFIG += staticlib
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# count heap allocations per traced stage (replaces global operator new)
+allocation_counters: DEFINES += ALLOCATION_COUNTERS
+
+SOURCES += \
+    iconwriter.cpp \
+    iconreader.cpp \
+    iconsource.cpp \
+    layerset.cpp \
+    sizeplanner.cpp \
+    sizeestimator.cpp \
+    packbits.cpp \
+    outputcache.cpp \
+    trace.cpp \
+    memoryusage.cpp \
+    multiexport.cpp \
+    atlas.cpp \
+    project.cpp \
+    bezelfield.cpp \
+    glyphcache.cpp
+
+HEADERS += \
+    iconformat.h \
+    iconwriter.h \
+    iconreader.h \
+    iconsource.h \
+    layer.h \
+    layerset.h \
+    sizeplanner.h \
+    sizeestimator.h \
+    packbits.h \
+    outputcache.h \
+    trace.h \
+    memoryusage.h \
+    multiexport.h \
+    atlas.h \
+    project.h \
+    bezelfield.h \
+    glyphcache.h \
+    standardoutput.h
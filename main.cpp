@@ -24,7 +24,43 @@
 #include "xmltools.h"
 #include "variable.h"
 #include "settings.h"
+#include "commandline.h"
+#include "trace.h"
 #include <QApplication>
+#include <QScopedPointer>
+#include <QWindow>
+
+/**
+ * @brief The FirstFrame class records time to first frame when a window is first exposed
+ */
+class FirstFrame final : public QObject {
+public:
+    explicit FirstFrame( QObject *parent = nullptr ) : QObject( parent ) {}
+
+protected:
+    /**
+     * @brief eventFilter
+     * @param object
+     * @param event
+     * @return
+     */
+    bool eventFilter( QObject *object, QEvent *event ) override {
+        QWindow *window( qobject_cast<QWindow*>( object ));
+
+        if ( event->type() == QEvent::Expose && window != nullptr && window->isExposed()) {
+            const qint64 elapsed = Trace::instance()->elapsed();
+
+            Trace::instance()->add( "Startup::firstFrame", 0, elapsed );
+            qCInfo( Trace_::Debug ) << "time to first frame" << QString( "%1 ms" ).arg( static_cast<double>( elapsed ) / 1000000.0, 0, 'f', 1 );
+
+            // only the first frame is of interest
+            object->removeEventFilter( this );
+            this->deleteLater();
+        }
+
+        return QObject::eventFilter( object, event );
+    }
+};
 
 /**
  * @brief qMain
@@ -33,32 +69,58 @@
  * @return
  */
 int main( int argc, char *argv[] ) {
-    QApplication a( argc, argv );
+    // start the trace clock, startup time (including application setup) is measured from here
+    Trace::instance();
+
+    // headless modes run without a display (no widgets or platform plugin needed)
+    CommandLine commandLine;
+    QStringList arguments;
+    for ( int y = 0; y < argc; y++ )
+        arguments << QString::fromLocal8Bit( argv[y] );
+
+    const bool headless = commandLine.isHeadless( arguments );
+    QScopedPointer<QCoreApplication> application( headless ? new QCoreApplication( argc, argv ) : new QApplication( argc, argv ));
+    QCoreApplication::setApplicationVersion( APP_VERSION );
 
     // add variables
     Variable::instance()->add( "previousOpenPath", "" );
     Variable::instance()->add( "previousSavePath", "" );
-    Variable::instance()->add( "settings/layerTemplate", static_cast<int>( Settings::Windows7 ));
-    Variable::instance()->add( "settings/customTemplate", "16,32,48,64,256" );
-    Variable::instance()->add( "settings/compressThreshold", Ui::ThresholdScale );
-    Variable::instance()->add( "settings/compress", true );
-    Variable::instance()->add( "settings/macOS", false );
+    Settings::registerVariables();
 
     // read configuration
     XMLTools::instance()->read();
 
+    // headless conversion (configuration is not written back)
+    if ( commandLine.parse( application->arguments())) {
+        const int result = commandLine.exec();
+
+        Trace::instance()->save();
+        GarbageMan::instance()->clear();
+        delete GarbageMan::instance();
+
+        return result;
+    }
+
     // open main window
     MainWindow::instance();
     MainWindow::instance()->initialize();
     MainWindow::instance()->show();
 
-    // clean up on exit
+    // time to first frame (the native window is created by show)
+    if ( MainWindow::instance()->windowHandle() != nullptr )
+        MainWindow::instance()->windowHandle()->installEventFilter( new FirstFrame( application.data()));
+
+    // persist settings in the background as they change
+    XMLTools::instance()->setAutoSave();
+
+    // clean up on exit (flushes a pending save, if any)
     qApp->connect( qApp, &QApplication::aboutToQuit, []() {
         XMLTools::instance()->write();
+        Trace::instance()->save();
         GarbageMan::instance()->clear();
 
         delete GarbageMan::instance();
     } );
 
-    return a.exec();
+    return application->exec();
 }
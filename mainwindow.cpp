@@ -24,7 +24,6 @@
 //  aliasing layers
 //  disabling layers
 //  generic icon creation
-//  project save/load
 //  icon crop dialog
 //  icon resource export
 //  make generic icons for layers only?
@@ -32,7 +31,6 @@
 // GENERIC ICON MAKER:
 //  multi layered design
 //  multi-type design (text, shape, etc.)
-//  basic bezel support (draw, fill, etc.)
 //  image import
 //  save settings/project
 //
@@ -50,6 +48,11 @@
 #include <QInputDialog>
 #include <QMessageBox>
 #include <designer.h>
+#include "atlas.h"
+#include "project.h"
+#include "iconreader.h"
+#include "iconsource.h"
+#include "imageloader.h"
 #include "iconwriter.h"
 #include "layermodel.h"
 #include "main.h"
@@ -57,6 +60,20 @@
 #include <QDebug>
 #include "settings.h"
 #include "layer.h"
+#include "sizeestimator.h"
+#include "sizeplanner.h"
+#include "memoryusage.h"
+#include "trace.h"
+#include "undocommands.h"
+#include <QJsonArray>
+#include <QLabel>
+#include <QStatusBar>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QFontDatabase>
+#include <QSaveFile>
+#include <QUndoStack>
+#include <QtConcurrent>
 
 /**
  * @brief MainWindow::MainWindow
@@ -66,9 +83,45 @@ MainWindow::MainWindow( QWidget *parent ) :
     QMainWindow( parent ),
     ui( new Ui::MainWindow ),
     model( new LayerModel()),
-    settingsDialog( new Settings( this )) {
+    settingsDialog( new Settings( this )),
+    imageLoader( new ImageLoader( this )),
+    exportWatcher( new QFutureWatcher<bool>( this )),
+    exportProgress( new QProgressBar()),
+    cancelButton( new QPushButton( this->tr( "Cancel" ))),
+    memoryLabel( new QLabel()),
+    sizeLabel( new QLabel()),
+    estimator( new SizeEstimator()),
+    estimateWatcher( new QFutureWatcher<qint64>( this )),
+    estimatePending( false ),
+    undoStack( new QUndoStack( this )) {
 
     this->ui->setupUi( this );
+
+    // layer edits are undoable (commands hold implicitly shared pixels)
+    QAction *undoAction( this->undoStack->createUndoAction( this, this->tr( "Undo" )));
+    QAction *redoAction( this->undoStack->createRedoAction( this, this->tr( "Redo" )));
+    undoAction->setShortcuts( QKeySequence::Undo );
+    redoAction->setShortcuts( QKeySequence::Redo );
+    this->ui->toolBar->addSeparator();
+    this->ui->toolBar->addAction( undoAction );
+    this->ui->toolBar->addAction( redoAction );
+    this->undoStack->setUndoLimit( UndoCommands_::Limit );
+
+    // export progress is shown in the status bar while writing
+    this->exportProgress->setMaximumWidth( 160 );
+    this->exportProgress->setTextVisible( false );
+    this->exportProgress->hide();
+    this->cancelButton->hide();
+    this->statusBar()->addPermanentWidget( this->exportProgress );
+    this->statusBar()->addPermanentWidget( this->cancelButton );
+    this->statusBar()->addPermanentWidget( this->sizeLabel );
+    this->statusBar()->addPermanentWidget( this->memoryLabel );
+    this->connect( this->cancelButton, &QPushButton::clicked, [ this ]() {
+        this->exportCancelled.store( 1 );
+        this->cancelButton->setEnabled( false );
+    } );
+    this->connect( this->exportWatcher, &QFutureWatcher<bool>::finished, this, &MainWindow::exportFinished );
+    this->connect( this->estimateWatcher, &QFutureWatcher<qint64>::finished, this, &MainWindow::estimateFinished );
 }
 
 /**
@@ -88,29 +141,205 @@ Layer *MainWindow::scaleToLayer( int scale ) const {
 /**
  * @brief MainWindow::setPixmap
  * @param pixmap
+ * @param renderer optionally renders the source directly at each layer size (instead of downscaling pixmap)
  */
-void MainWindow::setPixmap( const QPixmap &px ) {
-    QPixmap pixmap( px );
-
-    // resize if larger than 512
-    if ( pixmap.width() > Ui::MaximumScale || pixmap.height() > Ui::MaximumScale ) {
-        if ( pixmap.width() > pixmap.height())
-            pixmap = pixmap.scaledToHeight( Ui::MaximumScale, Qt::SmoothTransformation );
-        else if ( pixmap.width() < pixmap.height())
-            pixmap = pixmap.scaledToWidth( Ui::MaximumScale, Qt::SmoothTransformation );
-        else
-            pixmap = pixmap.scaled( Ui::MaximumScale, Ui::MaximumScale, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+void MainWindow::setPixmap( const QPixmap &px, const std::function<QImage( int )> &renderer ) {
+    const TraceScope trace( "MainWindow::setPixmap" );
+    QImage image;
+
+    this->renderer = renderer;
+
+    {
+        const TraceScope convert( "QPixmap::toImage" );
+        image = px.toImage();
+    }
+
+    {
+        const TraceScope fit( "IconSource::fitImage" );
+        this->scaled = IconSource::fitImage( image );
     }
-    this->scaled = pixmap;
 
     // generate mipmaps
     this->generateLayers( this->settingsDialog->currentScales());
 
     // update pixmap and display its scale
     if ( !this->layers.isEmpty())
-        this->ui->pixmapLabel->setPixmap( this->layers.last()->pixmap );
+        this->ui->pixmapLabel->setPixmap( this->layers.last()->pixmap());
+
+    this->ui->stackedWidget->setCurrentIndex( Preview );
+}
+
+/**
+ * @brief MainWindow::importIcon replaces layers with entries of an existing icon
+ * @param fileName
+ * @return
+ */
+bool MainWindow::importIcon( const QString &fileName ) {
+    bool macOS = false;
+    const QList<Layer*> imported( IconReader().read( fileName, &macOS ));
+
+    if ( imported.isEmpty())
+        return false;
+
+    // match output format to the imported icon
+    this->matchOutputFormat( macOS );
+
+    // entries are decoded only when displayed
+    this->clearLayers();
+    this->renderer = nullptr;
+    foreach ( Layer *layer, imported )
+        this->insertLayer( layer );
+    this->resetModel();
+
+    // use the largest entry as source for restored layers
+    this->scaled = this->layers.last()->image();
+    this->ui->pixmapLabel->setPixmap( QPixmap::fromImage( this->scaled ));
+    this->ui->stackedWidget->setCurrentIndex( Preview );
+
+    return true;
+}
+
+/**
+ * @brief MainWindow::matchOutputFormat switches to (or away from) the macOS template
+ * @param macOS
+ */
+void MainWindow::matchOutputFormat( bool macOS ) {
+    if ( macOS ) {
+        Settings_::Template.setValue( Settings::macOS );
+        Settings_::MacOS.setValue( true );
+    } else {
+        if ( Settings_::Template.value() == Settings::macOS )
+            Settings_::Template.setValue( Settings::Windows7 );
+        Settings_::MacOS.setValue( false );
+    }
+}
 
+/**
+ * @brief MainWindow::openProject restores layers (decoded when displayed) and the designer composition
+ * @param fileName
+ * @return
+ */
+bool MainWindow::openProject( const QString &fileName ) {
+    const QSharedPointer<Project> project( Project::open( fileName ));
+    if ( project.isNull())
+        return false;
+
+    const QVariantMap document( project->document());
+    const QImage source( project->image( document["source"].toByteArray()));
+    if ( source.isNull())
+        return false;
+
+    // match output format to the project
+    this->matchOutputFormat( document["macOS"].toBool());
+
+    this->clearLayers();
+    this->renderer = nullptr;
+    this->scaled = source;
+    foreach ( const QVariant &value, document["layers"].toList()) {
+        const QVariantMap map( value.toMap());
+        const int scale = map["scale"].toInt();
+        const int encoding = map["encoding"].toInt();
+
+        // skip corrupted entries (same limits as generated layers, writers switch on encodings)
+        if ( scale < Ui::MinimumScale || scale > Ui::MaximumScale || encoding < static_cast<int>( Layer::Encodings::Bitmap ) || encoding > static_cast<int>( Layer::Encodings::Palette ))
+            continue;
+
+        Layer *layer( new Layer());
+        layer->setScale( scale );
+        layer->setDoubleScale( map["doubleScale"].toBool());
+        layer->setEncoding( static_cast<Layer::Encodings>( encoding ));
+        layer->setOverriden( map["overriden"].toBool());
+        layer->setDecoder( project->decoder( map["image"].toByteArray()));
+        this->insertLayer( layer );
+    }
+    this->resetModel();
+
+    this->ui->pixmapLabel->setPixmap( QPixmap::fromImage( this->scaled ));
     this->ui->stackedWidget->setCurrentIndex( Preview );
+
+    if ( document.contains( "designer" ))
+        Designer::loadComposition( document["designer"].toList(), project );
+
+    return true;
+}
+
+/**
+ * @brief MainWindow::saveProject stores source, layers (with overrides) and the designer composition
+ * @param fileName
+ * @return
+ */
+bool MainWindow::saveProject( const QString &fileName ) const {
+    ProjectWriter writer;
+    QVariantMap document;
+    QVariantList layers;
+
+    document["source"] = writer.addImage( this->scaled );
+    document["macOS"] = Settings_::MacOS.value();
+
+    // layer images are stored too (imported and overridden ones cannot be regenerated)
+    foreach ( const Layer *layer, this->layers ) {
+        QVariantMap map;
+
+        map["scale"] = layer->scale();
+        map["doubleScale"] = layer->isDoubleScale();
+        map["encoding"] = static_cast<int>( layer->encoding());
+        map["overriden"] = layer->isOverriden();
+        map["image"] = writer.addImage( layer->image());
+        layers << map;
+    }
+    document["layers"] = layers;
+
+    // an unopened designer has nothing to save
+    if ( Designer::isCreated())
+        document["designer"] = Designer::instance()->composition( writer );
+
+    writer.setDocument( document );
+    return writer.write( fileName );
+}
+
+/**
+ * @brief MainWindow::on_actionOpenProject_triggered
+ */
+void MainWindow::on_actionOpenProject_triggered() {
+    QString path( Variable::instance()->string( "previousOpenPath" ));
+
+    if ( path.isEmpty() || !QDir( path ).exists())
+        path = QDir::currentPath();
+
+    const QString fileName( QFileDialog::getOpenFileName( this, this->tr( "Open Project" ), path, this->tr( "Project Files (*.bip)" )));
+    if ( fileName.isEmpty())
+        return;
+
+    Variable::instance()->setString( "previousOpenPath", QFileInfo( fileName ).absolutePath());
+
+    if ( !this->openProject( fileName ))
+        QMessageBox::critical( this, Ui::AppName, this->tr( "Could not open project \"%1\"." ).arg( fileName ), QMessageBox::Ok );
+}
+
+/**
+ * @brief MainWindow::on_actionSaveProject_triggered
+ */
+void MainWindow::on_actionSaveProject_triggered() {
+    QString path( Variable::instance()->string( "previousSavePath" ));
+
+    if ( path.isEmpty() || !QDir( path ).exists())
+        path = QDir::currentPath();
+
+    QString fileName( QFileDialog::getSaveFileName( this, this->tr( "Save Project" ), path, this->tr( "Project Files (*.bip)" )));
+    if ( fileName.isEmpty())
+        return;
+
+    if ( !fileName.endsWith( ".bip" ))
+        fileName.append( ".bip" );
+
+    Variable::instance()->setString( "previousSavePath", QFileInfo( fileName ).absolutePath());
+
+    if ( !this->saveProject( fileName )) {
+        QMessageBox::critical( this, Ui::AppName, this->tr( "Could not save project \"%1\"." ).arg( fileName ), QMessageBox::Ok );
+        return;
+    }
+
+    this->statusBar()->showMessage( this->tr( "Saved \"%1\"" ).arg( QFileInfo( fileName ).fileName()), 5000 );
 }
 
 /**
@@ -124,15 +353,21 @@ void MainWindow::initialize() {
     this->connect( this->ui->stackedWidget, &QStackedWidget::currentChanged, [ this ]( int index ) {
         this->ui->dockWidget->setEnabled( index == Preview );
         this->ui->actionExport->setEnabled( index == Preview );
+        this->ui->actionAtlas->setEnabled( index == Preview );
+        this->ui->actionSaveProject->setEnabled( index == Preview );
+        this->ui->actionOptimize->setEnabled( index == Preview );
         this->ui->actionClear->setEnabled( index == Preview );
     } );
     this->ui->dockWidget->setEnabled( false );
     this->ui->actionExport->setEnabled( false );
+    this->ui->actionAtlas->setEnabled( false );
+    this->ui->actionSaveProject->setEnabled( false );
+    this->ui->actionOptimize->setEnabled( false );
     this->ui->actionClear->setEnabled( false );
 
     // layer dock button enabler/disabler
     auto buttonTest = [ this ]() {
-        const bool macOS = Variable::instance()->isEnabled( "settings/macOS" );
+        const bool macOS = Settings_::MacOS.value();
         const bool valid = this->ui->layerView->currentIndex().isValid() && !macOS;
         this->ui->addButton->setEnabled( !macOS );
         this->ui->repopulateButton->setEnabled( !macOS );
@@ -154,9 +389,8 @@ void MainWindow::initialize() {
         }
     };
 
-    // open pixmap lambda
-    auto openPixmap = [ this ]( bool &ok ) {
-        QPixmap pixmap;
+    // open pixmap lambda (decodes on a worker, returns false if no file was chosen)
+    auto openPixmap = [ this ]( const std::function<void( const QPixmap & )> &ready ) {
         QString path( Variable::instance()->string( "previousOpenPath" ));
         const QDir dir( path );
 
@@ -164,56 +398,52 @@ void MainWindow::initialize() {
         if ( path.isEmpty() || !dir.exists())
             path = QDir::currentPath();
 
-        // failure by default
-        ok = false;
-
         // get fileName
         const QString fileName( QFileDialog::getOpenFileName( this, this->tr( "Open Image" ),
                                                               path,
                                                               this->tr( "Image Files (*.png *.jpg *.bmp *.svg)" )));
 
         if ( fileName.isEmpty())
-            return pixmap;
+            return false;
 
-        // pre-render svs to maximum scale (ignores aspect ratio)
-        if ( fileName.endsWith( ".svg" )) {
-            QIcon icon;
+        // store new path
+        Variable::instance()->setString( "previousOpenPath", QFileInfo( fileName ).absolutePath());
 
-            icon.addFile( fileName, QSize( Ui::MaximumScale, Ui::MaximumScale ));
-            if ( icon.isNull()) {
-                QMessageBox::critical( this, this->tr( "Image selector" ),
-                                       this->tr( "Invalid svg. Try another one." ),
-                                       QMessageBox::Ok );
-            }
+        // svgs are pre-rendered to maximum scale by the loader
+        this->statusBar()->showMessage( this->tr( "Loading \"%1\"" ).arg( QFileInfo( fileName ).fileName()));
+        this->imageLoader->load( fileName, [ this, ready ]( const QImage &image ) {
+            this->statusBar()->clearMessage();
 
-            pixmap = icon.pixmap( Ui::MaximumScale, Ui::MaximumScale );
-        } else {
             // validate pixmap
-            if ( !pixmap.load( fileName ))
+            if ( image.isNull()) {
                 QMessageBox::critical( this, this->tr( "Image selector" ),
                                        this->tr( "Invalid image. Try another image." ),
                                        QMessageBox::Ok );
-        }
+                return;
+            }
 
-        // check if pixmap is valid
-        if ( !pixmap.isNull())
-            ok = true;
+            ready( QPixmap::fromImage( image ));
+        } );
 
-        // store new path
-        Variable::instance()->setString( "previousOpenPath", QFileInfo( fileName ).absolutePath());
-
-        // return loaded pixmap
-        return pixmap;
+        return true;
     };
 
     // check button state on index change (disable by default)
     this->connect( this->ui->layerView->selectionModel(), &QItemSelectionModel::selectionChanged, [ this, buttonTest ]() {
         buttonTest();
 
-        if ( !this->layers.isEmpty())
-            this->ui->pixmapLabel->setPixmap( this->layers.at( this->ui->layerView->currentIndex().row())->pixmap );
-        else
+        const QModelIndex index( this->ui->layerView->currentIndex());
+        if ( !this->layers.isEmpty() && index.isValid()) {
+            const Layer *layer( this->layers.at( index.row()));
+            const bool decoded = layer->isDecoded();
+
+            // imported entries are decoded when first shown, add their thumbnail then
+            this->ui->pixmapLabel->setPixmap( layer->pixmap());
+            if ( !decoded )
+                emit this->model->dataChanged( index, index, QVector<int>() << Qt::DecorationRole );
+        } else {
             this->ui->pixmapLabel->setPixmap( QPixmap());
+        }
     } );
     buttonTest();
 
@@ -256,16 +486,10 @@ void MainWindow::initialize() {
 
             if ( this->layerMap.contains( scale )) {
                 if ( checked ) {
-                    bool ok;
-                    QPixmap pixmap;
-
-                    // get pixmap
-                    pixmap = openPixmap( ok );
-                    if ( !ok )
-                        return;
-
-                    // override layer pixmap
-                    this->overrideLayer( scale, pixmap );
+                    // override layer pixmap once decoded
+                    openPixmap( [ this, scale ]( const QPixmap &pixmap ) {
+                        this->overrideLayer( scale, pixmap );
+                    } );
                 } else {
                     this->restoreLayer( scale );
                 }
@@ -280,23 +504,46 @@ void MainWindow::initialize() {
         if ( index.isValid()) {
             Layer *layer( this->scaleToLayer( this->ui->layerView->currentIndex().data( LayerModel::ScaleRole ).toInt()));
 
-            if ( layer != nullptr )
-                layer->setCompressed( checked );
+            if ( layer != nullptr && layer->isCompressed() != checked ) {
+                Layer state( *layer );
+
+                state.setCompressed( checked );
+                this->undoStack->push( new LayerStateCommand( this, layer, state, checked ? this->tr( "Compress %1x%1 layer" ).arg( layer->scale()) : this->tr( "Uncompress %1x%1 layer" ).arg( layer->scale())));
+            }
         }
     } );
 
     // image selector lambda
     this->connect( this->ui->openButton, &QPushButton::clicked, [ this, openPixmap ]() {
-        bool ok;
-        QPixmap pixmap;
+        // make mipMaps once decoded
+        openPixmap( [ this ]( const QPixmap &pixmap ) {
+            this->setPixmap( pixmap );
+        } );
+    } );
+
+    // icon import lambda
+    this->connect( this->ui->importButton, &QPushButton::clicked, [ this ]() {
+        QString path( Variable::instance()->string( "previousOpenPath" ));
+        const QDir dir( path );
+
+        // check previous path
+        if ( path.isEmpty() || !dir.exists())
+            path = QDir::currentPath();
 
-        // get pixmap
-        pixmap = openPixmap( ok );
-        if ( !ok )
+        // get fileName
+        const QString fileName( QFileDialog::getOpenFileName( this, this->tr( "Import Icon" ),
+                                                              path,
+                                                              this->tr( "Icon Files (*.ico *.icns)" )));
+        if ( fileName.isEmpty())
             return;
 
-        // make mipMaps
-        this->setPixmap( pixmap );
+        // store new path
+        Variable::instance()->setString( "previousOpenPath", QFileInfo( fileName ).absolutePath());
+
+        if ( !this->importIcon( fileName ))
+            QMessageBox::critical( this, this->tr( "Icon import" ),
+                                   this->tr( "Invalid icon. Try another one." ),
+                                   QMessageBox::Ok );
     } );
 
     // repopulate lambda
@@ -308,19 +555,19 @@ void MainWindow::initialize() {
 
         // update pixmap and display its scale
         if ( !this->layers.isEmpty())
-            this->ui->pixmapLabel->setPixmap( this->layers.last()->pixmap );
+            this->ui->pixmapLabel->setPixmap( this->layers.last()->pixmap());
 
         buttonTest();
     } );
 
-    // icon maker lambda
+    // icon maker lambda (designer is built on first use)
     this->connect( this->ui->makeButton, &QPushButton::clicked, []() {
         Designer::instance()->show();
     } );
 
-    // initialize icon designer
-    Designer::instance();
-    Designer::instance()->setupLayers();
+    // enumerate installed fonts in the background, so the designer's font
+    // combo box finds the font database already populated
+    this->fontWarmup = QtConcurrent::run( []() { QFontDatabase().families(); } );
 
     // add to garbage man
     GarbageMan::instance()->add( this );
@@ -330,11 +577,19 @@ void MainWindow::initialize() {
  * @brief MainWindow::~MainWindow
  */
 MainWindow::~MainWindow() {
+    // abandon running export (the temporary file is discarded)
+    this->exportCancelled.store( 1 );
+    this->exportWatcher->waitForFinished();
+    this->estimateWatcher->waitForFinished();
+    this->fontWarmup.waitForFinished();
+    delete this->estimator;
+
     this->clearLayers();
 
     // disconnect all lambdas, etc.
     this->disconnect( this->ui->makeButton, SLOT( clicked()));
     this->disconnect( this->ui->openButton, SLOT( clicked()));
+    this->disconnect( this->ui->importButton, SLOT( clicked()));
     this->disconnect( this->ui->addButton, SLOT( clicked()));
     this->disconnect( this->ui->removeButton, SLOT( clicked()));
     this->disconnect( this->ui->overrideButton, SLOT( clicked( bool )));
@@ -352,11 +607,14 @@ MainWindow::~MainWindow() {
  * @brief MainWindow::on_actionExport_triggered
  */
 void MainWindow::on_actionExport_triggered() {
-    const QPixmap *pixmap( &this->scaled );
-    bool ok = true;
+    const QImage *pixmap( &this->scaled );
     QString path( Variable::instance()->string( "previousSavePath" ));
     const QDir dir( path );
 
+    // one export at a time
+    if ( this->exportWatcher->isRunning())
+        return;
+
     // check previous path
     if ( path.isEmpty() || !dir.exists())
         path = QDir::currentPath();
@@ -374,47 +632,143 @@ void MainWindow::on_actionExport_triggered() {
     }
 
     // get fileName
-    const bool macOS = Variable::instance()->isEnabled( "settings/macOS" );
+    const bool macOS = Settings_::MacOS.value();
     QString fileName( QFileDialog::getSaveFileName( this, this->tr( "Save Icon" ), path, macOS ? this->tr( "ICNS Files (*.icns)" ) : this->tr( "Icon Files (*.ico)" )));
     if ( fileName.isEmpty())
         return;
 
-    // check if exists
-    QFile file( fileName );
-
     // add extension
     if ( !fileName.endsWith( macOS ? ".icns" : ".ico" ))
         fileName.append(  macOS ? ".icns" : ".ico" );
 
-    if ( file.exists()) {
-        // check if file is readable
-        if ( !file.open( QIODevice::ReadOnly )) {
-            QMessageBox::critical( this, Ui::AppName,
-                                   this->tr( "Cannot open destination file." ),
-                                   QMessageBox::Ok );
-            return;
+    // store new path
+    Variable::instance()->setString( "previousSavePath", QFileInfo( fileName ).absolutePath());
+
+    // snapshot layers, so they can be edited while writing
+    QList<Layer> snapshot;
+    foreach ( const Layer *layer, this->layers )
+        snapshot << *layer;
+
+    // write out on a worker thread into a temporary file, replacing destination only on success
+    const WriterOptions options( Settings::writerOptions());
+    MemoryUsage::instance()->resetPeak();
+    this->exportCancelled.store( 0 );
+    this->exportProgress->setRange( 0, snapshot.count());
+    this->exportProgress->setValue( 0 );
+    this->exportProgress->show();
+    this->cancelButton->setEnabled( true );
+    this->cancelButton->show();
+    this->ui->actionExport->setEnabled( false );
+    this->statusBar()->showMessage( this->tr( "Writing \"%1\"" ).arg( QFileInfo( fileName ).fileName()));
+
+    this->exportWatcher->setProperty( "fileName", fileName );
+    this->exportWatcher->setFuture( QtConcurrent::run( [ this, fileName, options, snapshot ]() {
+        QList<Layer> layers( snapshot );
+        QList<Layer*> pointers;
+        QSaveFile file( fileName );
+        IconWriter writer( options );
+
+        for ( int y = 0; y < layers.count(); y++ )
+            pointers << &layers[y];
+
+        writer.setProgress( [ this ]( int written, int ) {
+            QMetaObject::invokeMethod( this->exportProgress, "setValue", Qt::QueuedConnection, Q_ARG( int, written ));
+            return this->exportCancelled.load() == 0;
+        } );
+
+        if ( !file.open( QIODevice::WriteOnly ))
+            return false;
+
+        // report is only touched by the worker until the watcher finishes
+        if ( !writer.write( &file, pointers, &this->pendingReport )) {
+            file.cancelWriting();
+            return false;
         }
-        file.close();
 
-        // check if file is writable
-        if ( !file.open( QIODevice::WriteOnly )) {
-            QMessageBox::critical( this, Ui::AppName,
-                                   this->tr( "Cannot write destination file." ),
-                                   QMessageBox::Ok );
+        return file.commit();
+    } ));
+}
+
+/**
+ * @brief MainWindow::on_actionAtlas_triggered packs all layers into a texture atlas
+ */
+void MainWindow::on_actionAtlas_triggered() {
+    QString path( Variable::instance()->string( "previousSavePath" ));
+    Atlas atlas( AtlasOptions( 1, true ));
+
+    if ( this->layers.isEmpty())
+        return;
+
+    if ( path.isEmpty() || !QDir( path ).exists())
+        path = QDir::currentPath();
+
+    QString fileName( QFileDialog::getSaveFileName( this, this->tr( "Save Atlas" ), path, this->tr( "PNG Files (*.png)" )));
+    if ( fileName.isEmpty())
+        return;
+
+    if ( !fileName.endsWith( ".png" ))
+        fileName.append( ".png" );
+
+    Variable::instance()->setString( "previousSavePath", QFileInfo( fileName ).absolutePath());
+
+    atlas.add( this->layers );
+    if ( !atlas.pack() || !atlas.write( fileName )) {
+        QMessageBox::critical( this, Ui::AppName, this->tr( "Could not write atlas \"%1\"." ).arg( fileName ), QMessageBox::Ok );
+        return;
+    }
+
+    this->statusBar()->showMessage( this->tr( "Saved \"%1\" (%2x%3, %4 entries)" ).arg( QFileInfo( fileName ).fileName()).arg( atlas.image().width()).arg( atlas.image().height()).arg( atlas.entries().count()), 5000 );
+}
+
+/**
+ * @brief MainWindow::exportFinished reports the result of a background export
+ */
+void MainWindow::exportFinished() {
+    const bool cancelled = this->exportCancelled.load() != 0;
+
+    this->exportProgress->hide();
+    this->cancelButton->hide();
+    this->ui->actionExport->setEnabled( this->ui->stackedWidget->currentIndex() == Preview );
+    this->updateMemoryUsage();
+
+    // cancel may arrive after the last entry, the file is then written anyway
+    if ( !this->exportWatcher->result()) {
+        if ( cancelled ) {
+            this->statusBar()->showMessage( this->tr( "Export cancelled" ), 5000 );
             return;
         }
-        file.close();
-    }
 
-    if ( !ok )
+        this->statusBar()->clearMessage();
+        QMessageBox::critical( this, Ui::AppName, this->tr( "Cannot write destination file." ), QMessageBox::Ok );
         return;
+    }
 
+    // show written sizes in the layer list
+    this->exportReport = this->pendingReport;
+    this->model->resetModel();
 
-    // store new path
-    Variable::instance()->setString( "previousSavePath", QFileInfo( fileName ).absolutePath());
+    this->statusBar()->showMessage( this->tr( "Saved \"%1\" (%2)" ).arg( QFileInfo( this->exportWatcher->property( "fileName" ).toString()).fileName()).arg( this->locale().formattedDataSize( this->exportReport.bytes )), 5000 );
+}
+
+/**
+ * @brief MainWindow::on_actionOptimize_triggered
+ */
+void MainWindow::on_actionOptimize_triggered() {
+    const qint64 budget = static_cast<qint64>( Settings_::SizeBudget.value()) * 1024;
+    const bool legacy = Settings_::Template.value() == Settings::Legacy;
+    SizePlanner planner( budget, Settings_::MacOS.value(), !legacy, Settings_::LegacyICNS.value());
+
+    if ( this->layers.isEmpty())
+        return;
 
-    // write out
-    IconWriter::instance()->write( fileName, this->layers );
+    // pick encodings and display decisions in the layer list
+    planner.plan( this->layers );
+    this->resetModel();
+
+    if ( planner.isWithinBudget())
+        this->statusBar()->showMessage( this->tr( "Estimated icon size: %1" ).arg( this->locale().formattedDataSize( planner.total())));
+    else
+        this->statusBar()->showMessage( this->tr( "Estimated icon size: %1 (exceeds budget of %2)" ).arg( this->locale().formattedDataSize( planner.total())).arg( this->locale().formattedDataSize( planner.budget())));
 }
 
 /**
@@ -422,11 +776,13 @@ void MainWindow::on_actionExport_triggered() {
  * @param scales
  */
 void MainWindow::generateLayers( const QList<int> scales ) {
+    const TraceScope trace( "MainWindow::generateLayers" );
+
     this->clearLayers();
 
     // build unique mipmaps for each scale
     // TODO: use fast downscaling on create and smooth on write
-    if ( Variable::instance()->isEnabled( "settings/macOS" )) {
+    if ( Settings_::MacOS.value()) {
         foreach ( const Ui::macOSLayer &layer, Ui::macOSLayers )
             this->addLayer( layer.scale, layer.doubleScale, false );
     } else {
@@ -442,7 +798,7 @@ void MainWindow::generateLayers( const QList<int> scales ) {
  * @param scales
  */
 void MainWindow::addLayer( int scale, bool doubleScale, bool reset ) {
-    bool compress = Variable::instance()->isEnabled( "settings/compress" );
+    bool compress = Settings_::Compress.value();
 
     if ( this->scaled.isNull())
         return;
@@ -451,13 +807,13 @@ void MainWindow::addLayer( int scale, bool doubleScale, bool reset ) {
         return;
 
     if ( compress ) {
-        if ( scale < Variable::instance()->integer( "settings/compressThreshold" ))
+        if ( scale < Settings_::CompressThreshold.value())
             compress = false;
     }
 
-    Layer *layer( new Layer( this->scaled, scale, compress, doubleScale ));
+    Layer *layer( new Layer( this->sourceImage( scale ), scale, compress, doubleScale ));
     this->layers << layer;
-    this->layerMap[scale] = layer;
+    this->mapLayer( scale );
 
     if ( reset )
         this->resetModel();
@@ -478,10 +834,27 @@ void MainWindow::overrideLayer( int scale, const QPixmap &pixmap ) {
         px = pixmap.scaled( scale, scale, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
 
     Layer *layer( this->layerMap[scale] );
-    layer->pixmap = px;
-    layer->setOverriden( true );
+    Layer state( *layer );
+    state.setImage( px.toImage());
+    state.setOverriden( true );
+    state.setEncoding( layer->encoding());
 
-    this->resetModel();
+    this->undoStack->push( new LayerStateCommand( this, layer, state, this->tr( "Override %1x%1 layer" ).arg( scale )));
+}
+
+/**
+ * @brief MainWindow::sourceImage returns the source for a layer of the given size
+ * @param scale
+ * @return direct render at that size if available, otherwise the full size source
+ */
+QImage MainWindow::sourceImage( int scale ) const {
+    if ( this->renderer ) {
+        const QImage image( this->renderer( scale ));
+        if ( !image.isNull())
+            return image;
+    }
+
+    return this->scaled;
 }
 
 /**
@@ -493,10 +866,12 @@ void MainWindow::restoreLayer( int scale ) {
         return;
 
     Layer *layer( this->layerMap[scale] );
-    layer->pixmap = this->scaled.scaled( scale, scale, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
-    layer->setOverriden( false );
+    Layer state( *layer );
+    state.setImage( this->sourceImage( scale ).scaled( scale, scale, Qt::IgnoreAspectRatio, Qt::SmoothTransformation ));
+    state.setOverriden( false );
+    state.setEncoding( layer->encoding());
 
-    this->resetModel();
+    this->undoStack->push( new LayerStateCommand( this, layer, state, this->tr( "Restore %1x%1 layer" ).arg( scale )));
 }
 
 /**
@@ -507,27 +882,156 @@ void MainWindow::removeLayer( int scale ) {
     if ( this->scaled.isNull() || !this->layerMap.contains( scale ))
         return;
 
-    Layer *layer( this->layerMap[scale] );
+    this->undoStack->push( new RemoveLayerCommand( this, this->layerMap[scale] ));
+}
+
+/**
+ * @brief MainWindow::insertLayer adds a previously taken layer back
+ * @param layer
+ */
+void MainWindow::insertLayer( Layer *layer ) {
+    this->layers << layer;
+    this->mapLayer( layer->scale());
+}
+
+/**
+ * @brief MainWindow::takeLayer removes a layer without deleting it
+ * @param layer
+ */
+void MainWindow::takeLayer( Layer *layer ) {
     this->layers.removeAll( layer );
-    this->layerMap.remove( scale );
-    delete layer;
-    this->resetModel();
+    this->mapLayer( layer->scale());
+}
+
+/**
+ * @brief MainWindow::mapLayer points the scale lookup at a remaining layer of that scale
+ * @param scale
+ *
+ * Standard layers take precedence over their @2x twins (macOS icp5 and ic11
+ * share a scale), so the lookup does not depend on insertion order.
+ */
+void MainWindow::mapLayer( int scale ) {
+    Layer *mapped = nullptr;
+
+    foreach ( Layer *layer, this->layers ) {
+        if ( layer->scale() != scale )
+            continue;
+
+        if ( mapped == nullptr || ( mapped->isDoubleScale() && !layer->isDoubleScale()))
+            mapped = layer;
+    }
+
+    if ( mapped == nullptr )
+        this->layerMap.remove( scale );
+    else
+        this->layerMap[scale] = mapped;
 }
 
 /**
  * @brief MainWindow::reset
  */
 void MainWindow::resetModel() {
+    // layers changed, previous export no longer applies
+    this->exportReport = ExportReport();
+
     std::sort( this->layers.begin(), this->layers.end(), []( Layer *one, Layer *two ) { return one->scale() < two->scale(); } );
     this->model->resetModel();
+    this->updateMemoryUsage();
+    this->updateEstimate();
+}
+
+/**
+ * @brief MainWindow::updateEstimate estimates file size in the background
+ *
+ * Only one estimate runs at a time; changes made meanwhile are picked up
+ * by a single follow-up run.
+ */
+void MainWindow::updateEstimate() {
+    if ( this->estimateWatcher->isRunning()) {
+        this->estimatePending = true;
+        return;
+    }
+
+    this->estimatePending = false;
+    if ( this->layers.isEmpty()) {
+        this->sizeLabel->clear();
+        return;
+    }
+
+    // snapshot layers (pixels are implicitly shared)
+    QList<Layer> snapshot;
+    foreach ( const Layer *layer, this->layers )
+        snapshot << *layer;
+
+    const WriterOptions options( Settings::writerOptions());
+    SizeEstimator *estimator( this->estimator );
+    this->sizeLabel->setText( this->tr( "Estimating size..." ));
+    this->estimateWatcher->setFuture( QtConcurrent::run( [ estimator, options, snapshot ]() {
+        QList<Layer> layers( snapshot );
+        QList<Layer*> pointers;
+
+        for ( int y = 0; y < layers.count(); y++ )
+            pointers << &layers[y];
+
+        estimator->setOptions( options );
+        return estimator->estimate( pointers );
+    } ));
+}
+
+/**
+ * @brief MainWindow::estimateFinished displays estimated size (or re-runs if layers changed)
+ */
+void MainWindow::estimateFinished() {
+    if ( this->estimatePending ) {
+        this->updateEstimate();
+        return;
+    }
+
+    this->sizeLabel->setText( this->tr( "Estimated size: %1" ).arg( this->locale().formattedDataSize( this->estimateWatcher->result())));
+    this->sizeLabel->setToolTip( this->tr( "%1 of %2 entries re-encoded" ).arg( this->estimator->encoded()).arg( this->layers.count()));
+}
+
+/**
+ * @brief MainWindow::updateMemoryUsage shows held pixel bytes in the status bar (details in tooltip)
+ */
+void MainWindow::updateMemoryUsage() {
+    const QJsonObject report( MemoryUsage::report( this->layers, this->scaled ));
+    qint64 designerBytes = 0;
+    QStringList details;
+
+    details << this->tr( "Source: %1" ).arg( this->locale().formattedDataSize( static_cast<qint64>( report["sourceBytes"].toDouble())));
+    foreach ( const QJsonValue &value, report["layers"].toArray()) {
+        const QJsonObject layer( value.toObject());
+        details << this->tr( "Layer %1x%1%2: %3" ).arg( layer["scale"].toInt()).arg( layer["doubleScale"].toBool() ? "@2x" : "" ).arg( this->locale().formattedDataSize( static_cast<qint64>( layer["bytes"].toDouble())));
+    }
+
+    foreach ( const DesignerLayer *layer, Designer::isCreated() ? Designer::instance()->layers : QList<DesignerLayer*>()) {
+        if ( layer->pixelBytes() > 0 )
+            details << this->tr( "Designer \"%1\": %2" ).arg( layer->name()).arg( this->locale().formattedDataSize( layer->pixelBytes()));
+        designerBytes += layer->pixelBytes();
+    }
+
+    details << this->tr( "Export peak (transient): %1" ).arg( this->locale().formattedDataSize( static_cast<qint64>( report["transientPeak"].toDouble())));
+    foreach ( const QJsonValue &value, report["stages"].toArray()) {
+        const QJsonObject stage( value.toObject());
+        details << this->tr( "%1: %2 calls, %3 ms%4" ).arg( stage["name"].toString()).arg( stage["calls"].toInt()).arg( stage["milliseconds"].toDouble(), 0, 'f', 1 )
+                   .arg( stage.contains( "allocations" ) ? this->tr( ", %1 allocations" ).arg( static_cast<qint64>( stage["allocations"].toDouble())) : QString());
+    }
+
+    const qint64 total = static_cast<qint64>( report["sourceBytes"].toDouble() + report["layerBytes"].toDouble()) + designerBytes;
+    this->memoryLabel->setText( this->tr( "Pixels: %1" ).arg( this->locale().formattedDataSize( total )));
+    this->memoryLabel->setToolTip( details.join( "\n" ));
 }
 
 /**
  * @brief MainWindow::clearLayers
  */
 void MainWindow::clearLayers() {
+    // commands refer to the layers (and own removed ones)
+    this->undoStack->clear();
     qDeleteAll( this->layers );
     this->layers.clear();
+    this->layerMap.clear();
 }
 
 /**
@@ -544,4 +1048,7 @@ void MainWindow::on_actionClear_triggered() {
  */
 void MainWindow::on_actionSettings_triggered() {
     this->settingsDialog->exec();
+
+    // output format may have changed
+    this->updateEstimate();
 }
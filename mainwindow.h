@@ -21,15 +21,28 @@
 //
 // includes
 //
+#include <QAtomicInt>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QImage>
 #include <QMainWindow>
 #include <QMap>
+#include "iconformat.h"
+#include "iconwriter.h"
+#include <functional>
 
 //
 // classes
 //
+class ImageLoader;
 class LayerModel;
 class Settings;
 class Layer;
+class SizeEstimator;
+class QLabel;
+class QProgressBar;
+class QPushButton;
+class QUndoStack;
 
 /**
  * @brief The Ui namespace
@@ -38,29 +51,14 @@ namespace Ui {
 class MainWindow;
 const static QList<int> DefaultScales = QList<int>() << 16 << 32 << 48 << 256;
 const static QString AppName( QT_TR_NOOP_UTF8( "BurningIcon" ));
-constexpr int MinimumScale = 4;
-constexpr int ThresholdScale = 256;
-constexpr int MaximumScale = 1024;
-
-struct macOSLayer {
-    QString code;
-    int scale;
-    bool doubleScale;
-    macOSLayer( const QString &c, int scale, bool doubleScale = false ) : code( c ), scale( scale ), doubleScale( doubleScale ) {}
-};
-
-static const QList<macOSLayer> macOSLayers = QList<macOSLayer>() <<
-                                                                    macOSLayer( "icp4", 16 ) <<
-                                                                    macOSLayer( "icp5", 32 ) <<
-                                                                    macOSLayer( "icp6", 64 ) <<
-                                                                    macOSLayer( "ic07", 128 ) <<
-                                                                    macOSLayer( "ic08", 256 ) <<
-                                                                    macOSLayer( "ic09", 512 ) <<
-                                                                    macOSLayer( "ic10", 1024 ) <<
-                                                                    macOSLayer( "ic11", 32, true ) <<
-                                                                    macOSLayer( "ic12", 64, true ) <<
-                                                                    macOSLayer( "ic13", 256, true ) <<
-                                                                    macOSLayer( "ic14", 512, true );
+using IconFormat::MinimumScale;
+using IconFormat::ThresholdScale;
+using IconFormat::MaximumScale;
+using IconFormat::macOSLayer;
+using IconFormat::macOSLayers;
+using IconFormat::macOSLegacyLayer;
+using IconFormat::macOSLegacyLayers;
+using IconFormat::macOSCode;
 }
 
 /**
@@ -70,6 +68,8 @@ class MainWindow final : public QMainWindow {
     Q_OBJECT
     Q_ENUMS( StackPages )
     Q_DISABLE_COPY( MainWindow )
+    friend class LayerStateCommand;
+    friend class RemoveLayerCommand;
 
 public:
     enum StackPages {
@@ -85,10 +85,22 @@ public:
     Layer *scaleToLayer( int scale ) const;
 
 public:
-    void setPixmap( const QPixmap &pixmap );
+    void setPixmap( const QPixmap &pixmap, const std::function<QImage( int )> &renderer = nullptr );
+    bool importIcon( const QString &fileName );
+    bool openProject( const QString &fileName );
+    bool saveProject( const QString &fileName ) const;
+    const ExportReport &lastExport() const { return this->exportReport; }
 
 private slots:
     void on_actionExport_triggered();
+    void on_actionAtlas_triggered();
+    void on_actionOpenProject_triggered();
+    void on_actionSaveProject_triggered();
+    void exportFinished();
+    void updateMemoryUsage();
+    void updateEstimate();
+    void estimateFinished();
+    void on_actionOptimize_triggered();
     void generateLayers( const QList<int> scales = Ui::DefaultScales );
     void addLayer( int scale, bool doubleScale = false, bool resetModel = false );
     void overrideLayer( int scale, const QPixmap &pixmap );
@@ -101,9 +113,29 @@ private slots:
 
 private:
     explicit MainWindow( QWidget *parent = nullptr );
-    QPixmap scaled;
+    void insertLayer( Layer *layer );
+    void takeLayer( Layer *layer );
+    void mapLayer( int scale );
+    void matchOutputFormat( bool macOS );
+    QImage sourceImage( int scale ) const;
+    QImage scaled;
+    std::function<QImage( int )> renderer;
     Ui::MainWindow *ui;
     LayerModel *model;
     QMap<int, Layer*> layerMap;
     Settings *settingsDialog;
+    ImageLoader *imageLoader;
+    QFutureWatcher<bool> *exportWatcher;
+    QProgressBar *exportProgress;
+    QPushButton *cancelButton;
+    QLabel *memoryLabel;
+    QLabel *sizeLabel;
+    SizeEstimator *estimator;
+    QFutureWatcher<qint64> *estimateWatcher;
+    bool estimatePending;
+    QAtomicInt exportCancelled;
+    ExportReport pendingReport;
+    ExportReport exportReport;
+    QUndoStack *undoStack;
+    QFuture<void> fontWarmup;
 };
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+//
+// includes
+//
+#include "memoryusage.h"
+#include "layer.h"
+#include "trace.h"
+#include <QJsonArray>
+#ifdef ALLOCATION_COUNTERS
+#include <cstdlib>
+#include <new>
+#endif
+
+#ifdef ALLOCATION_COUNTERS
+/**
+ * @brief allocationCount counts allocations of the current thread (no locking needed)
+ */
+static thread_local quint64 allocationCount = 0;
+
+/**
+ * @brief operator new
+ * @param size
+ * @return
+ */
+void *operator new( std::size_t size ) {
+    void *pointer = std::malloc( size == 0 ? 1 : size );
+
+    if ( pointer == nullptr )
+        throw std::bad_alloc();
+
+    allocationCount++;
+    return pointer;
+}
+
+/**
+ * @brief operator new[]
+ * @param size
+ * @return
+ */
+void *operator new[]( std::size_t size ) {
+    return ::operator new( size );
+}
+
+/**
+ * @brief operator delete
+ * @param pointer
+ */
+void operator delete( void *pointer ) noexcept {
+    std::free( pointer );
+}
+
+/**
+ * @brief operator delete[]
+ * @param pointer
+ */
+void operator delete[]( void *pointer ) noexcept {
+    std::free( pointer );
+}
+#endif
+
+/**
+ * @brief MemoryUsage::acquire adds transient bytes and raises the peak if needed
+ * @param bytes
+ */
+void MemoryUsage::acquire( qint64 bytes ) {
+    const qint64 current = this->m_transient.fetchAndAddRelaxed( bytes ) + bytes;
+    qint64 peak = this->m_peak.load();
+
+    while ( current > peak && !this->m_peak.testAndSetRelaxed( peak, current, peak ))
+        ;
+}
+
+/**
+ * @brief MemoryUsage::countsAllocations
+ * @return true if heap allocations are counted in this build
+ */
+bool MemoryUsage::countsAllocations() {
+#ifdef ALLOCATION_COUNTERS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief MemoryUsage::allocations
+ * @return number of heap allocations made by the calling thread so far
+ */
+quint64 MemoryUsage::allocations() {
+#ifdef ALLOCATION_COUNTERS
+    return allocationCount;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief MemoryUsage::report lists pixel bytes held per layer, transient peak and per-stage statistics
+ * @param layers
+ * @param source
+ * @return
+ */
+QJsonObject MemoryUsage::report( const QList<Layer*> &layers, const QImage &source ) {
+    QJsonObject root;
+    QJsonArray entries;
+    QJsonArray stages;
+    qint64 total = 0;
+
+    // deferred (imported) layers hold nothing until decoded
+    foreach ( const Layer *layer, layers ) {
+        QJsonObject entry;
+        const qint64 bytes = layer->isDecoded() ? MemoryUsage::imageBytes( layer->image()) : 0;
+
+        entry["scale"] = layer->scale();
+        entry["doubleScale"] = layer->isDoubleScale();
+        entry["bytes"] = static_cast<double>( bytes );
+        entries << entry;
+        total += bytes;
+    }
+
+    foreach ( const Trace::Stage &stage, Trace::instance()->stages()) {
+        QJsonObject entry;
+
+        entry["name"] = QString::fromLatin1( stage.name );
+        entry["calls"] = stage.calls;
+        entry["milliseconds"] = static_cast<double>( stage.nanoseconds ) / 1000000.0;
+        if ( MemoryUsage::countsAllocations())
+            entry["allocations"] = static_cast<double>( stage.allocations );
+        stages << entry;
+    }
+
+    root["sourceBytes"] = static_cast<double>( MemoryUsage::imageBytes( source ));
+    root["layers"] = entries;
+    root["layerBytes"] = static_cast<double>( total );
+    root["transientPeak"] = static_cast<double>( MemoryUsage::instance()->peak());
+    root["allocationCounting"] = MemoryUsage::countsAllocations();
+    root["stages"] = stages;
+
+    return root;
+}
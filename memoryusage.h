@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+#pragma once
+
+//
+// includes
+//
+#include <QAtomicInteger>
+#include <QImage>
+#include <QJsonObject>
+#include <QList>
+
+//
+// classes
+//
+class Layer;
+
+/**
+ * @brief The MemoryUsage class accounts pixel and transient (export) bytes
+ *
+ * Heap allocations are only counted in builds configured with
+ * CONFIG+=allocation_counters, which replaces the global operator new.
+ *
+ * Like Trace, a process-wide instance that the core library allows for
+ * diagnostics only: counters are atomic and never affect output.
+ */
+class MemoryUsage final {
+    Q_DISABLE_COPY( MemoryUsage )
+
+public:
+    static MemoryUsage *instance() { static MemoryUsage instance; return &instance; }
+    ~MemoryUsage() = default;
+    void acquire( qint64 bytes );
+    void release( qint64 bytes ) { this->m_transient.fetchAndSubRelaxed( bytes ); }
+    qint64 transient() const { return this->m_transient.load(); }
+    qint64 peak() const { return this->m_peak.load(); }
+    void resetPeak() { this->m_peak.store( this->m_transient.load()); }
+    static bool countsAllocations();
+    static quint64 allocations();
+    static qint64 imageBytes( const QImage &image ) { return image.isNull() ? 0 : static_cast<qint64>( image.bytesPerLine()) * image.height(); }
+    static QJsonObject report( const QList<Layer*> &layers, const QImage &source = QImage());
+
+private:
+    MemoryUsage() : m_transient( 0 ), m_peak( 0 ) {}
+    QAtomicInteger<qint64> m_transient;
+    QAtomicInteger<qint64> m_peak;
+};
+
+/**
+ * @brief The MemoryReservation class accounts transient bytes for the enclosing block
+ */
+class MemoryReservation final {
+    Q_DISABLE_COPY( MemoryReservation )
+
+public:
+    explicit MemoryReservation( qint64 bytes = 0 ) : m_bytes( 0 ) { this->add( bytes ); }
+    ~MemoryReservation() { MemoryUsage::instance()->release( this->m_bytes ); }
+    void add( qint64 bytes ) { MemoryUsage::instance()->acquire( bytes ); this->m_bytes += bytes; }
+
+private:
+    qint64 m_bytes;
+};
@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "multiexport.h"
+#include "iconwriter.h"
+#include "layer.h"
+#include "trace.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QSaveFile>
+#include <QSet>
+#include <QtConcurrent>
+#include <algorithm>
+
+/**
+ * @brief The AppleIcon struct is a single iOS AppIcon set entry
+ */
+struct AppleIcon {
+    const char *idiom;
+    qreal size;
+    int scale;
+};
+
+static const AppleIcon appleIcons[] = {
+    { "iphone", 20, 2 }, { "iphone", 20, 3 }, { "iphone", 29, 2 }, { "iphone", 29, 3 },
+    { "iphone", 40, 2 }, { "iphone", 40, 3 }, { "iphone", 60, 2 }, { "iphone", 60, 3 },
+    { "ipad", 20, 1 }, { "ipad", 20, 2 }, { "ipad", 29, 1 }, { "ipad", 29, 2 },
+    { "ipad", 40, 1 }, { "ipad", 40, 2 }, { "ipad", 76, 1 }, { "ipad", 76, 2 },
+    { "ipad", 83.5, 2 }, { "ios-marketing", 1024, 1 }
+};
+
+/**
+ * @brief MultiExport::target parses a target name (case insensitive)
+ * @param name
+ * @return
+ */
+ExportTarget MultiExport::target( const QString &name ) {
+    for ( int y = static_cast<int>( ExportTarget::ICO ); y <= static_cast<int>( ExportTarget::Favicon ); y++ ) {
+        if ( !QString::compare( name.trimmed(), MultiExport::targetName( static_cast<ExportTarget>( y )), Qt::CaseInsensitive ))
+            return static_cast<ExportTarget>( y );
+    }
+
+    return ExportTarget::NoTarget;
+}
+
+/**
+ * @brief MultiExport::targetName
+ * @param target
+ * @return
+ */
+QString MultiExport::targetName( ExportTarget target ) {
+    switch ( target ) {
+    case ExportTarget::ICO:
+        return "ico";
+
+    case ExportTarget::ICNS:
+        return "icns";
+
+    case ExportTarget::Android:
+        return "android";
+
+    case ExportTarget::iOS:
+        return "ios";
+
+    case ExportTarget::Hicolor:
+        return "hicolor";
+
+    case ExportTarget::Favicon:
+        return "favicon";
+
+    case ExportTarget::NoTarget:
+        break;
+    }
+
+    return QString();
+}
+
+/**
+ * @brief MultiExport::outputs returns files of a single target (paths relative to the export directory)
+ * @param target
+ * @return
+ */
+QList<MultiExport::Output> MultiExport::outputs( ExportTarget target ) const {
+    QList<Output> outputs;
+
+    switch ( target ) {
+    case ExportTarget::ICO:
+        outputs << Output( Output::Kinds::ICO, this->m_options.name + ".ico", this->m_options.icoScales );
+        break;
+
+    case ExportTarget::ICNS:
+    {
+        QList<int> scales;
+        foreach ( const IconFormat::macOSLayer &layer, IconFormat::macOSLayers )
+            scales << layer.scale;
+
+        outputs << Output( Output::Kinds::ICNS, this->m_options.name + ".icns", scales );
+        break;
+    }
+
+    case ExportTarget::Android:
+    {
+        const QList<QPair<QString, int> > densities( QList<QPair<QString, int> >() << qMakePair( QString( "mdpi" ), 48 ) << qMakePair( QString( "hdpi" ), 72 ) << qMakePair( QString( "xhdpi" ), 96 ) << qMakePair( QString( "xxhdpi" ), 144 ) << qMakePair( QString( "xxxhdpi" ), 192 ));
+
+        for ( const QPair<QString, int> &density : densities )
+            outputs << Output( Output::Kinds::PNG, QString( "android/res/mipmap-%1/ic_launcher.png" ).arg( density.first ), QList<int>() << density.second );
+
+        // store listing
+        outputs << Output( Output::Kinds::PNG, "android/ic_launcher-playstore.png", QList<int>() << 512 );
+        break;
+    }
+
+    case ExportTarget::iOS:
+    {
+        QJsonArray images;
+        QSet<QString> files;
+
+        for ( const AppleIcon &icon : appleIcons ) {
+            const QString size( QString::number( icon.size ));
+            const QString fileName( QString( "Icon-%1@%2x.png" ).arg( size ).arg( icon.scale ));
+            QJsonObject image;
+
+            image["idiom"] = icon.idiom;
+            image["size"] = QString( "%1x%1" ).arg( size );
+            image["scale"] = QString( "%1x" ).arg( icon.scale );
+            image["filename"] = fileName;
+            images << image;
+
+            // idioms share files of equal pixel size
+            if ( !files.contains( fileName )) {
+                files << fileName;
+                outputs << Output( Output::Kinds::PNG, "AppIcon.appiconset/" + fileName, QList<int>() << qRound( icon.size * icon.scale ));
+            }
+        }
+
+        QJsonObject info, contents;
+        info["version"] = 1;
+        info["author"] = "xcode";
+        contents["images"] = images;
+        contents["info"] = info;
+        outputs << Output( Output::Kinds::JSON, "AppIcon.appiconset/Contents.json", QList<int>(), QJsonDocument( contents ).toJson());
+        break;
+    }
+
+    case ExportTarget::Hicolor:
+        foreach ( const int scale, QList<int>() << 16 << 22 << 24 << 32 << 48 << 64 << 128 << 256 << 512 )
+            outputs << Output( Output::Kinds::PNG, QString( "hicolor/%1x%1/apps/%2.png" ).arg( scale ).arg( this->m_options.name ), QList<int>() << scale );
+        break;
+
+    case ExportTarget::Favicon:
+        outputs << Output( Output::Kinds::ICO, "favicon/favicon.ico", QList<int>() << 16 << 32 << 48 );
+        outputs << Output( Output::Kinds::PNG, "favicon/favicon-16x16.png", QList<int>() << 16 );
+        outputs << Output( Output::Kinds::PNG, "favicon/favicon-32x32.png", QList<int>() << 32 );
+        outputs << Output( Output::Kinds::PNG, "favicon/apple-touch-icon.png", QList<int>() << 180 );
+        outputs << Output( Output::Kinds::PNG, "favicon/android-chrome-192x192.png", QList<int>() << 192 );
+        outputs << Output( Output::Kinds::PNG, "favicon/android-chrome-512x512.png", QList<int>() << 512 );
+        break;
+
+    case ExportTarget::NoTarget:
+        break;
+    }
+
+    return outputs;
+}
+
+/**
+ * @brief MultiExport::outputs returns files of all targets
+ * @return
+ */
+QList<MultiExport::Output> MultiExport::outputs() const {
+    QList<Output> outputs;
+
+    foreach ( const ExportTarget target, this->m_options.targets )
+        outputs << this->outputs( target );
+
+    return outputs;
+}
+
+/**
+ * @brief MultiExport::scales returns the union of pixel sizes required by all targets
+ * @return
+ */
+QList<int> MultiExport::scales() const {
+    QSet<int> unique;
+
+    foreach ( const Output &output, this->outputs()) {
+        foreach ( const int scale, output.scales ) {
+            if ( scale >= IconFormat::MinimumScale && scale <= IconFormat::MaximumScale )
+                unique << scale;
+        }
+    }
+
+    QList<int> scales( unique.values());
+    std::sort( scales.begin(), scales.end());
+    return scales;
+}
+
+/**
+ * @brief MultiExport::write resamples, encodes and writes all targets
+ * @param source
+ * @param directory
+ * @param written optional list of written files
+ * @return
+ */
+bool MultiExport::write( const IconSource &source, const QString &directory, QStringList *written ) const {
+    const TraceScope trace( "MultiExport::write" );
+    const QList<Output> outputs( this->outputs());
+    const QList<int> scales( this->scales());
+    QSet<int> png;
+    QDir dir( directory );
+
+    if ( !source.isValid() || outputs.isEmpty())
+        return false;
+
+    // only sizes stored as png need a payload
+    foreach ( const Output &output, outputs ) {
+        foreach ( const int scale, output.scales ) {
+            if ( output.kind != Output::Kinds::ICO || ( this->m_options.compress && scale >= this->m_options.threshold ))
+                png << scale;
+        }
+    }
+
+    // resample each size once
+    const QImage image( source.image());
+    const bool compress = this->m_options.compress;
+    const int threshold = this->m_options.threshold;
+    QList<Layer*> layers( QtConcurrent::blockingMapped<QList<Layer*> >( scales, std::function<Layer*( const int & )>( [ image, compress, threshold ]( const int &scale ) {
+        return new Layer( image, scale, compress && scale >= threshold );
+    } )));
+
+    QMap<int, Layer*> pyramid;
+    foreach ( Layer *layer, layers )
+        pyramid[layer->scale()] = layer;
+
+    // encode each png payload once
+    {
+        const TraceScope encode( "MultiExport::encode" );
+        QtConcurrent::blockingMap( layers, [ png ]( Layer *layer ) {
+            if ( png.contains( layer->scale()))
+                layer->setPayload( IconWriter::pngData( layer->image()));
+        } );
+    }
+
+    // create directories up front, files are written concurrently
+    foreach ( const Output &output, outputs )
+        dir.mkpath( QFileInfo( dir.filePath( output.path )).absolutePath());
+
+    const bool legacy = this->m_options.legacy;
+    const QList<bool> results( QtConcurrent::blockingMapped<QList<bool> >( outputs, std::function<bool( const Output & )>( [ dir, pyramid, legacy ]( const Output &output ) {
+        QSaveFile file( dir.filePath( output.path ));
+        QList<Layer*> entries;
+        QList<Layer> icns;
+        bool ok = file.open( QIODevice::WriteOnly );
+
+        if ( !ok )
+            return false;
+
+        switch ( output.kind ) {
+        case Output::Kinds::PNG:
+            ok = !output.scales.isEmpty() && pyramid.contains( output.scales.first()) && file.write( pyramid[output.scales.first()]->payload()) == pyramid[output.scales.first()]->payload().size();
+            break;
+
+        case Output::Kinds::JSON:
+            ok = file.write( output.data ) == output.data.size();
+            break;
+
+        case Output::Kinds::ICO:
+            foreach ( const int scale, output.scales ) {
+                if ( pyramid.contains( scale ))
+                    entries << pyramid[scale];
+            }
+            ok = !entries.isEmpty() && IconWriter( WriterOptions( false )).write( &file, entries );
+            break;
+
+        case Output::Kinds::ICNS:
+            // lightweight copies (shared pixels and payloads) carry the retina flag
+            foreach ( const IconFormat::macOSLayer &layer, IconFormat::macOSLayers ) {
+                if ( !pyramid.contains( layer.scale ))
+                    continue;
+
+                icns << *pyramid[layer.scale];
+                icns.last().setDoubleScale( layer.doubleScale );
+            }
+            for ( int y = 0; y < icns.count(); y++ )
+                entries << &icns[y];
+
+            ok = !entries.isEmpty() && IconWriter( WriterOptions( true, legacy )).write( &file, entries );
+            break;
+
+        case Output::Kinds::NoKind:
+            ok = false;
+            break;
+        }
+
+        return ok && file.commit();
+    } )));
+
+    qDeleteAll( layers );
+
+    // report
+    bool ok = true;
+    for ( int y = 0; y < outputs.count(); y++ ) {
+        if ( !results.at( y )) {
+            qCCritical( MultiExport_::Debug ) << QString( "could not write \"%1\"" ).arg( dir.filePath( outputs.at( y ).path ));
+            ok = false;
+        } else if ( written != nullptr ) {
+            *written << dir.filePath( outputs.at( y ).path );
+        }
+    }
+
+    return ok;
+}
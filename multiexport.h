@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+#pragma once
+
+//
+// includes
+//
+#include <QList>
+#include <QLoggingCategory>
+#include <QString>
+#include <QStringList>
+#include "iconformat.h"
+#include "iconsource.h"
+
+/**
+ * @brief The MultiExport_ namespace
+ */
+namespace MultiExport_ {
+const static QLoggingCategory Debug( "export" );
+}
+
+/**
+ * @brief The ExportTarget enum lists platforms a single export can produce
+ */
+enum class ExportTarget {
+    NoTarget = -1,
+    ICO,
+    ICNS,
+    Android,
+    iOS,
+    Hicolor,
+    Favicon
+};
+
+/**
+ * @brief The MultiExportOptions struct
+ */
+struct MultiExportOptions {
+    QList<ExportTarget> targets;
+    QString name;
+    QList<int> icoScales;
+    bool compress;
+    int threshold;
+    bool legacy;
+    MultiExportOptions( const QList<ExportTarget> &t = QList<ExportTarget>(), const QString &n = "icon", const QList<int> &s = QList<int>(), bool c = true, int th = IconFormat::ThresholdScale, bool l = true ) : targets( t ), name( n ), icoScales( s ), compress( c ), threshold( th ), legacy( l ) {}
+};
+
+/**
+ * @brief The MultiExport class writes several targets from one shared pyramid
+ *
+ * The union of all required pixel sizes is resampled once, each png payload
+ * is encoded once (and reused by ico, icns and plain png files alike) and
+ * all output files are written in parallel.
+ */
+class MultiExport final {
+public:
+    /**
+     * @brief The Output struct describes a single file of an export
+     */
+    struct Output {
+        enum class Kinds {
+            NoKind = -1,
+            PNG,
+            ICO,
+            ICNS,
+            JSON
+        };
+
+        Kinds kind;
+        QString path;
+        QList<int> scales;
+        QByteArray data;
+        Output( Kinds k = Kinds::NoKind, const QString &p = QString(), const QList<int> &s = QList<int>(), const QByteArray &d = QByteArray()) : kind( k ), path( p ), scales( s ), data( d ) {}
+    };
+
+    explicit MultiExport( const MultiExportOptions &options = MultiExportOptions()) : m_options( options ) {}
+    ~MultiExport() = default;
+    const MultiExportOptions &options() const { return this->m_options; }
+    QList<Output> outputs() const;
+    QList<int> scales() const;
+    bool write( const IconSource &source, const QString &directory, QStringList *written = nullptr ) const;
+    static ExportTarget target( const QString &name );
+    static QString targetName( ExportTarget target );
+
+private:
+    QList<Output> outputs( ExportTarget target ) const;
+    MultiExportOptions m_options;
+};
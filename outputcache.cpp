@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "outputcache.h"
+#include "standardoutput.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QTextStream>
+#ifdef Q_OS_LINUX
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+/**
+ * @brief OutputCache::OutputCache
+ * @param path cache directory (created if missing, the cache is invalid if empty)
+ */
+OutputCache::OutputCache( const QString &path ) : m_path( path ), m_hits( 0 ), m_misses( 0 ) {
+    if ( this->m_path.isEmpty())
+        return;
+
+    QDir dir( this->m_path );
+    if ( !dir.exists() && !dir.mkpath( dir.absolutePath())) {
+        this->m_path.clear();
+        return;
+    }
+    this->m_path = dir.absolutePath();
+
+    // read cumulative counters
+    this->readStatistics();
+}
+
+/**
+ * @brief OutputCache::readStatistics
+ */
+void OutputCache::readStatistics() {
+    QFile file( this->m_path + "/" + OutputCache_::StatisticsFile );
+
+    this->m_hits = this->m_misses = 0;
+    if ( file.open( QIODevice::ReadOnly | QIODevice::Text )) {
+        QTextStream stream( &file );
+        stream >> this->m_hits >> this->m_misses;
+        file.close();
+    }
+}
+
+/**
+ * @brief OutputCache::fileName returns cache entry path for the given input
+ * @param input source file contents
+ * @param parameters serialized template and encoding settings
+ * @param suffix
+ * @return
+ */
+QString OutputCache::fileName( const QByteArray &input, const QByteArray &parameters, const QString &suffix ) const {
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+
+    hash.addData( QCoreApplication::applicationVersion().toUtf8());
+    hash.addData( parameters );
+    hash.addData( input );
+
+    return this->m_path + "/" + QString::fromLatin1( hash.result().toHex()) + "." + suffix;
+}
+
+/**
+ * @brief OutputCache::deliver copies (or reflinks) a cache entry to output
+ *
+ * The output is replaced only once the copy is complete, and never shares
+ * storage with the cache entry that later edits could modify.
+ * @param cached
+ * @param output file name or '-' for stdout
+ * @return
+ */
+bool OutputCache::deliver( const QString &cached, const QString &output ) const {
+    if ( !QString::compare( output, "-" )) {
+        QFile in( cached );
+        QFile out;
+
+        if ( !in.open( QIODevice::ReadOnly ) || !StandardOutput::open( out ))
+            return false;
+
+        while ( !in.atEnd()) {
+            const QByteArray chunk( in.read( 65536 ));
+            if ( out.write( chunk ) != chunk.size())
+                return false;
+        }
+
+        return true;
+    }
+
+    QFile in( cached );
+    QSaveFile out( output );
+    if ( !in.open( QIODevice::ReadOnly ) || !out.open( QIODevice::WriteOnly ))
+        return false;
+
+#if defined( Q_OS_LINUX ) && defined( FICLONE )
+    // copy-on-write clone where the filesystem supports it
+    if ( !::ioctl( out.handle(), FICLONE, in.handle()))
+        return out.commit();
+#endif
+
+    while ( !in.atEnd()) {
+        const QByteArray chunk( in.read( 65536 ));
+        if ( chunk.isEmpty() || out.write( chunk ) != chunk.size()) {
+            out.cancelWriting();
+            return false;
+        }
+    }
+
+    return out.commit();
+}
+
+/**
+ * @brief OutputCache::record updates cumulative hit/miss counters
+ * @param hit
+ */
+void OutputCache::record( bool hit ) {
+    // other instances may update counters concurrently
+    QLockFile lock( this->m_path + "/" + OutputCache_::StatisticsFile + ".lock" );
+    if ( !lock.tryLock( OutputCache_::LockTimeout ))
+        return;
+
+    this->readStatistics();
+    if ( hit )
+        this->m_hits++;
+    else
+        this->m_misses++;
+
+    QSaveFile file( this->m_path + "/" + OutputCache_::StatisticsFile );
+    if ( file.open( QIODevice::WriteOnly | QIODevice::Text )) {
+        QTextStream stream( &file );
+        stream << this->m_hits << " " << this->m_misses << "\n";
+        stream.flush();
+        file.commit();
+    }
+}
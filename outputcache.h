@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QByteArray>
+#include <QString>
+
+/**
+ * @brief The OutputCache_ namespace
+ */
+namespace OutputCache_ {
+#ifdef Q_CC_MSVC
+static constexpr const char *CacheDir = "cache";
+static constexpr const char *StatisticsFile = "statistics";
+#else
+static constexpr const char __attribute__((unused)) *CacheDir = "cache";
+static constexpr const char __attribute__((unused)) *StatisticsFile = "statistics";
+#endif
+constexpr int LockTimeout = 1000;
+}
+
+/**
+ * @brief The OutputCache class stores encoded icons keyed by input and settings
+ */
+class OutputCache final {
+public:
+    explicit OutputCache( const QString &path );
+    ~OutputCache() = default;
+    QString path() const { return this->m_path; }
+    bool isValid() const { return !this->m_path.isEmpty(); }
+    QString fileName( const QByteArray &input, const QByteArray &parameters, const QString &suffix ) const;
+    bool deliver( const QString &cached, const QString &output ) const;
+    void record( bool hit );
+    qint64 hits() const { return this->m_hits; }
+    qint64 misses() const { return this->m_misses; }
+
+private:
+    void readStatistics();
+    QString m_path;
+    qint64 m_hits;
+    qint64 m_misses;
+};
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "packbits.h"
+#include <QtAlgorithms>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief PackBits::runLength returns number of bytes equal to the first one
+ * @param data
+ * @param length maximum run to look for
+ * @return
+ */
+int PackBits::runLength( const uchar *data, int length ) {
+    int run = 1;
+
+    if ( length <= 0 )
+        return 0;
+
+#ifdef __SSE2__
+    // compare 16 bytes at a time against the broadcast first byte
+    const __m128i value = _mm_set1_epi8( static_cast<char>( data[0] ));
+    while ( run + 16 <= length ) {
+        const __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( data + run ));
+        const uint mask = static_cast<uint>( _mm_movemask_epi8( _mm_cmpeq_epi8( block, value )));
+
+        if ( mask != 0xffff )
+            return run + static_cast<int>( qCountTrailingZeroBits( ~mask ));
+
+        run += 16;
+    }
+#endif
+
+    // scalar tail
+    while ( run < length && data[run] == data[0] )
+        run++;
+
+    return run;
+}
+
+/**
+ * @brief PackBits::encode appends an encoded channel to out
+ * @param out
+ * @param data
+ * @param length
+ */
+void PackBits::encode( QByteArray &out, const uchar *data, int length ) {
+    int pos = 0;
+
+    while ( pos < length ) {
+        const int run = PackBits::runLength( data + pos, qMin( PackBits::MaximumRun, length - pos ));
+
+        if ( run >= PackBits::MinimumRun ) {
+            out.append( static_cast<char>( run + 125 ));
+            out.append( static_cast<char>( data[pos] ));
+            pos += run;
+            continue;
+        }
+
+        // gather literals until the next worthwhile run
+        const int start = pos;
+        while ( pos < length && pos - start < PackBits::MaximumLiteral ) {
+            if ( PackBits::runLength( data + pos, qMin( PackBits::MinimumRun, length - pos )) >= PackBits::MinimumRun )
+                break;
+            pos++;
+        }
+
+        out.append( static_cast<char>( pos - start - 1 ));
+        out.append( reinterpret_cast<const char*>( data + start ), pos - start );
+    }
+}
+
+/**
+ * @brief PackBits::decode appends a decoded channel to out
+ * @param out
+ * @param data
+ * @param length available input
+ * @param expected number of bytes to decode
+ * @param consumed number of input bytes used
+ * @return false on malformed input
+ */
+bool PackBits::decode( QByteArray &out, const uchar *data, int length, int expected, int *consumed ) {
+    int pos = 0, written = 0;
+
+    while ( written < expected && pos < length ) {
+        const int control = data[pos++];
+
+        if ( control < 0x80 ) {
+            const int count = control + 1;
+            if ( pos + count > length || written + count > expected )
+                return false;
+
+            out.append( reinterpret_cast<const char*>( data + pos ), count );
+            pos += count;
+            written += count;
+        } else {
+            const int count = control - 125;
+            if ( pos >= length || written + count > expected )
+                return false;
+
+            out.append( count, static_cast<char>( data[pos++] ));
+            written += count;
+        }
+    }
+
+    if ( consumed != nullptr )
+        *consumed = pos;
+
+    return written == expected;
+}
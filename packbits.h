@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QByteArray>
+
+/**
+ * @brief The PackBits namespace (icns flavour of PackBits RLE)
+ *
+ * A control byte below 0x80 is followed by (n + 1) literal bytes,
+ * a control byte of 0x80 and above repeats the next byte (n - 125) times.
+ */
+namespace PackBits {
+static constexpr int MinimumRun = 3;
+static constexpr int MaximumRun = 130;
+static constexpr int MaximumLiteral = 128;
+
+int runLength( const uchar *data, int length );
+void encode( QByteArray &out, const uchar *data, int length );
+bool decode( QByteArray &out, const uchar *data, int length, int expected, int *consumed = nullptr );
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "project.h"
+#include "iconwriter.h"
+#include "trace.h"
+#include <QBuffer>
+#include <QDataStream>
+#include <QSaveFile>
+#include <limits>
+
+/**
+ * @brief ProjectWriter::addImage stores an image once (png compressed)
+ * @param image
+ * @return hash used to reference the image from the document
+ */
+QByteArray ProjectWriter::addImage( const QImage &image ) {
+    if ( image.isNull())
+        return QByteArray();
+
+    const QByteArray hash( IconWriter::imageHash( image ));
+    if ( !this->m_images.contains( hash )) {
+        this->m_images[hash] = IconWriter::pngData( image );
+        this->m_order << hash;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief ProjectWriter::write
+ * @param fileName
+ * @return
+ */
+bool ProjectWriter::write( const QString &fileName ) const {
+    const TraceScope trace( "ProjectWriter::write" );
+    QByteArray document;
+    QByteArray header;
+
+    {
+        QDataStream out( &document, QIODevice::WriteOnly );
+        out.setVersion( QDataStream::Qt_5_6 );
+        out << this->m_document;
+    }
+
+    // header and table go first, so blob offsets are known up front
+    const qint64 headerSize = 4 + 2 + 2 + 4 + 8 + 8;
+    const qint64 tableSize = static_cast<qint64>( Project_::HashSize + 8 + 8 ) * this->m_order.count();
+    qint64 offset = headerSize + tableSize + document.size();
+
+    QDataStream out( &header, QIODevice::WriteOnly );
+    out.setByteOrder( QDataStream::LittleEndian );
+    out << Project_::Magic << Project_::Version << static_cast<quint16>( 0 ) << static_cast<quint32>( this->m_order.count())
+        << static_cast<quint64>( headerSize + tableSize ) << static_cast<quint64>( document.size());
+
+    foreach ( const QByteArray &hash, this->m_order ) {
+        const qint64 size = this->m_images[hash].size();
+
+        out.writeRawData( hash.constData(), Project_::HashSize );
+        out << static_cast<quint64>( offset ) << static_cast<quint64>( size );
+        offset += size;
+    }
+
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) || file.write( header ) != header.size() || file.write( document ) != document.size())
+        return false;
+
+    foreach ( const QByteArray &hash, this->m_order ) {
+        const QByteArray &png = this->m_images[hash];
+
+        if ( file.write( png ) != png.size())
+            return false;
+    }
+
+    return file.commit();
+}
+
+/**
+ * @brief Project::~Project
+ */
+Project::~Project() {
+    if ( this->m_fallback.isEmpty() && this->m_data != nullptr )
+        this->m_file.unmap( const_cast<uchar*>( this->m_data ));
+}
+
+/**
+ * @brief Project::open maps a project file and parses its index
+ * @param fileName
+ * @return nullptr on failure
+ */
+QSharedPointer<Project> Project::open( const QString &fileName ) {
+    QSharedPointer<Project> project( new Project( fileName ));
+
+    if ( !project->load()) {
+        qCCritical( Project_::Debug ) << "could not read project" << fileName;
+        return QSharedPointer<Project>();
+    }
+
+    return project;
+}
+
+/**
+ * @brief Project::load
+ * @return
+ */
+bool Project::load() {
+    const TraceScope trace( "Project::load" );
+
+    if ( !this->m_file.open( QIODevice::ReadOnly ))
+        return false;
+
+    // map the whole file, fall back to reading where mapping is unsupported
+    this->m_size = this->m_file.size();
+    this->m_data = this->m_file.map( 0, this->m_size );
+    if ( this->m_data == nullptr ) {
+        this->m_fallback = this->m_file.readAll();
+        this->m_data = reinterpret_cast<const uchar*>( this->m_fallback.constData());
+        this->m_size = this->m_fallback.size();
+    }
+
+    // sizes and offsets below are handed to int based APIs
+    if ( this->m_data == nullptr || this->m_size > std::numeric_limits<int>::max())
+        return false;
+
+    // parse header and image table without copying
+    const QByteArray bytes( QByteArray::fromRawData( reinterpret_cast<const char*>( this->m_data ), static_cast<int>( this->m_size )));
+    QDataStream in( bytes );
+    quint32 magic, count;
+    quint16 version, reserved;
+    quint64 documentOffset, documentSize;
+
+    in.setByteOrder( QDataStream::LittleEndian );
+    in >> magic >> version >> reserved >> count >> documentOffset >> documentSize;
+    if ( in.status() != QDataStream::Ok || magic != Project_::Magic || version != Project_::Version )
+        return false;
+
+    // header and image table must end before the document (checked without overflow)
+    const quint64 size = static_cast<quint64>( this->m_size );
+    const quint64 tableOffset = static_cast<quint64>( in.device()->pos());
+    if ( documentOffset > size || documentSize > size - documentOffset || documentOffset < tableOffset ||
+         count > ( documentOffset - tableOffset ) / ( Project_::HashSize + 8 + 8 ))
+        return false;
+
+    for ( quint32 y = 0; y < count; y++ ) {
+        QByteArray hash( Project_::HashSize, 0 );
+        quint64 offset, blobSize;
+
+        if ( in.readRawData( hash.data(), Project_::HashSize ) != Project_::HashSize )
+            return false;
+
+        in >> offset >> blobSize;
+        if ( in.status() != QDataStream::Ok || offset > size || blobSize > size - offset )
+            return false;
+
+        this->m_images[hash] = Blob( static_cast<qint64>( offset ), static_cast<qint64>( blobSize ));
+    }
+
+    // the document is small (properties and hashes only)
+    QDataStream document( QByteArray::fromRawData( reinterpret_cast<const char*>( this->m_data ) + documentOffset, static_cast<int>( documentSize )));
+    document.setVersion( QDataStream::Qt_5_6 );
+    document >> this->m_document;
+
+    return document.status() == QDataStream::Ok;
+}
+
+/**
+ * @brief Project::image decodes an embedded image straight from the mapped file
+ * @param hash
+ * @return
+ */
+QImage Project::image( const QByteArray &hash ) const {
+    const TraceScope trace( "Project::image" );
+
+    if ( !this->m_images.contains( hash ))
+        return QImage();
+
+    const Blob blob( this->m_images[hash] );
+    return QImage::fromData( this->m_data + blob.offset, static_cast<int>( blob.size ), "PNG" );
+}
+
+/**
+ * @brief Project::decoder returns a deferred decoder (keeps the project mapped)
+ * @param hash
+ * @return
+ */
+std::function<QImage()> Project::decoder( const QByteArray &hash ) const {
+    const QSharedPointer<const Project> project( this->sharedFromThis());
+
+    return [ project, hash ]() { return project->image( hash ); };
+}
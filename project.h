@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+#pragma once
+
+//
+// includes
+//
+#include <QByteArray>
+#include <QEnableSharedFromThis>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QLoggingCategory>
+#include <QSharedPointer>
+#include <QVariantMap>
+#include <functional>
+
+/**
+ * @brief The Project_ namespace
+ *
+ * File layout (little endian):
+ *   magic (u32), version (u16), reserved (u16), image count (u32),
+ *   document offset (u64), document size (u64),
+ *   image table: count x { sha1 (20 bytes), offset (u64), size (u64) },
+ *   document (QDataStream serialized QVariantMap),
+ *   png blobs.
+ *
+ * Only the header, table and document are parsed on open; images stay in
+ * the memory-mapped file until decoded.
+ */
+namespace Project_ {
+const static QLoggingCategory Debug( "project" );
+constexpr quint32 Magic = 0x52504942; // "BIPR" little endian
+constexpr quint16 Version = 1;
+constexpr int HashSize = 20;
+}
+
+/**
+ * @brief The ProjectWriter class collects a document and deduplicated images
+ */
+class ProjectWriter final {
+public:
+    ProjectWriter() = default;
+    ~ProjectWriter() = default;
+    QByteArray addImage( const QImage &image );
+    void setDocument( const QVariantMap &document ) { this->m_document = document; }
+    int imageCount() const { return this->m_order.count(); }
+    bool write( const QString &fileName ) const;
+
+private:
+    QVariantMap m_document;
+    QHash<QByteArray, QByteArray> m_images;
+    QList<QByteArray> m_order;
+};
+
+/**
+ * @brief The Project class is a memory-mapped, lazily decoded project file
+ */
+class Project final : public QEnableSharedFromThis<Project> {
+    Q_DISABLE_COPY( Project )
+
+public:
+    ~Project();
+    static QSharedPointer<Project> open( const QString &fileName );
+    const QVariantMap &document() const { return this->m_document; }
+    bool contains( const QByteArray &hash ) const { return this->m_images.contains( hash ); }
+    QImage image( const QByteArray &hash ) const;
+    std::function<QImage()> decoder( const QByteArray &hash ) const;
+
+private:
+    /**
+     * @brief The Blob struct locates an embedded image
+     */
+    struct Blob {
+        qint64 offset;
+        qint64 size;
+        Blob( qint64 o = 0, qint64 s = 0 ) : offset( o ), size( s ) {}
+    };
+
+    explicit Project( const QString &fileName ) : m_file( fileName ), m_data( nullptr ), m_size( 0 ) {}
+    bool load();
+    QFile m_file;
+    QByteArray m_fallback;
+    const uchar *m_data;
+    qint64 m_size;
+    QHash<QByteArray, Blob> m_images;
+    QVariantMap m_document;
+};
@@ -24,6 +24,17 @@
 #include "variable.h"
 #include "mainwindow.h"
 
+//
+// handles (resolved in Settings::registerVariables)
+//
+Setting<int> Settings_::Template;
+Setting<QString> Settings_::CustomTemplate;
+Setting<int> Settings_::CompressThreshold;
+Setting<bool> Settings_::Compress;
+Setting<bool> Settings_::MacOS;
+Setting<bool> Settings_::LegacyICNS;
+Setting<int> Settings_::SizeBudget;
+
 /**
  * @brief Settings::Settings
  * @param parent
@@ -32,37 +43,20 @@ Settings::Settings( QWidget *parent ) : QDialog( parent ), ui( new Ui::Settings
     // set up ui
     this->ui->setupUi( this );
 
-    // get custom layer scales from valiable
-    const QStringList custom( Variable::instance()->string( "settings/customTemplate" ).split( "," ));
-    QList<int> customValues;
-    foreach ( const QString &num, custom ) {
-        bool ok;
-        const int value = num.toInt( &ok );
-
-        if ( ok )
-            customValues << value;
-    }
-
-    // fill out templates
-    this->layerTemplates[Legacy]    = LayerTemplate( this->tr( "Windows XP" ),
-                                                     QList<int>() << 16 << 32 << 48 );
-    this->layerTemplates[Windows7]  = LayerTemplate( this->tr( "Windows Vista/7" ),
-                                                     QList<int>() << 16 << 20 << 32 << 40 << 48 << 64 << 256 );
-    this->layerTemplates[Windows10] = LayerTemplate( this->tr( "Windows 10" ),
-                                                     QList<int>() << 16 << 20 << 24 << 28 << 30 << 31 << 32 << 40 << 42 << 47 << 48 << 56 << 60 << 63 << 84 << 256 );
-    this->layerTemplates[macOS]     = LayerTemplate( this->tr( "macOS" ), QList<int>(), true );
-    this->layerTemplates[Custom]    = LayerTemplate( this->tr( "Custom" ),
-                                                     customValues );
-
-    // add templates to comboBox
-    for ( int y = 0; y < TemplateCount; y++ )
+    // fill out templates and add them to comboBox
+    for ( int y = 0; y < TemplateCount; y++ ) {
+        this->layerTemplates[static_cast<Templates>( y )] = Settings::layerTemplate( static_cast<Templates>( y ));
         this->ui->layerCombo->addItem( this->layerTemplates[static_cast<Templates>( y )].name, static_cast<Templates>( y ));
+    }
 
     // store current template in a variable
     Variable::instance()->bind( "settings/layerTemplate", this->ui->layerCombo );
 
     // compression state lambda
-    auto compressionState = [ this ]() { this->ui->compressInteger->setEnabled( this->ui->compressBox->isChecked() && Variable::instance()->isDisabled( "settings/macOS" )); };
+    auto compressionState = [ this ]() {
+        this->ui->compressInteger->setEnabled( this->ui->compressBox->isChecked() && !Settings_::MacOS.value());
+        this->ui->legacyBox->setEnabled( Settings_::MacOS.value());
+    };
 
     // this lambda sets icon scales to an edit box
     auto displayScales = [ this, compressionState ]() {
@@ -80,7 +74,7 @@ Settings::Settings( QWidget *parent ) : QDialog( parent ), ui( new Ui::Settings
         if ( index == macOS ) {
             sizes = "16x16, 32x32, 64x64, 128x128, 256x256, 512x512, 1024, 16x16@2x, 32x32@2x, 128x128@2x, 256x256@2x";
             this->ui->compressBox->setDisabled( true );
-            Variable::instance()->enable( "settings/macOS" );
+            Settings_::MacOS.setValue( true );
         } else {
             // make a string of all available scales
             foreach ( const int size, layerTemplate.scales ) {
@@ -88,7 +82,7 @@ Settings::Settings( QWidget *parent ) : QDialog( parent ), ui( new Ui::Settings
                 y++;
             }
             this->ui->compressBox->setEnabled( true );
-            Variable::instance()->disable( "settings/macOS" );
+            Settings_::MacOS.setValue( false );
         }
 
         // set string to edit box
@@ -108,7 +102,7 @@ Settings::Settings( QWidget *parent ) : QDialog( parent ), ui( new Ui::Settings
     // update custom template
     this->connect( this->ui->layerEdit, &QLineEdit::editingFinished, [ this ]() {
         if ( static_cast<Templates>( this->ui->layerCombo->currentIndex()) == Custom ) {
-            Variable::instance()->setString( "settings/customTemplate", this->ui->layerEdit->text());
+            Settings_::CustomTemplate.setValue( this->ui->layerEdit->text());
         }
     } );
 
@@ -116,11 +110,123 @@ Settings::Settings( QWidget *parent ) : QDialog( parent ), ui( new Ui::Settings
     Variable::instance()->bind( "settings/compressThreshold", this->ui->compressInteger );
     Variable::instance()->bind( "settings/compress", this->ui->compressBox );
 
+    // legacy icns entries
+    Variable::instance()->bind( "settings/legacyICNS", this->ui->legacyBox );
+
+    // file size budget for the planner
+    Variable::instance()->bind( "settings/sizeBudget", this->ui->budgetInteger );
+
     // hide/show compression integer
     this->connect( this->ui->compressBox, &QCheckBox::toggled, compressionState );
     compressionState();
 }
 
+/**
+ * @brief Settings::layerTemplate returns predefined (or custom) layer template
+ * @param index
+ * @return
+ */
+LayerTemplate Settings::layerTemplate( Templates index ) {
+    return Settings::layerTemplate( index, *Variable::instance()->snapshot());
+}
+
+/**
+ * @brief Settings::layerTemplate returns predefined (or custom) layer template from a settings snapshot
+ * @param index
+ * @param settings
+ * @return
+ */
+LayerTemplate Settings::layerTemplate( Templates index, const VariableSnapshot &settings ) {
+    switch ( index ) {
+    case Legacy:
+        return LayerTemplate( Settings::tr( "Windows XP" ),
+                              QList<int>() << 16 << 32 << 48 );
+
+    case Windows7:
+        return LayerTemplate( Settings::tr( "Windows Vista/7" ),
+                              QList<int>() << 16 << 20 << 32 << 40 << 48 << 64 << 256 );
+
+    case Windows10:
+        return LayerTemplate( Settings::tr( "Windows 10" ),
+                              QList<int>() << 16 << 20 << 24 << 28 << 30 << 31 << 32 << 40 << 42 << 47 << 48 << 56 << 60 << 63 << 84 << 256 );
+
+    case macOS:
+        return LayerTemplate( Settings::tr( "macOS" ), QList<int>(), true );
+
+    case Custom:
+    {
+        // get custom layer scales from valiable
+        const QStringList custom( Settings_::CustomTemplate.value( settings ).split( "," ));
+        QList<int> customValues;
+        foreach ( const QString &num, custom ) {
+            bool ok;
+            const int value = num.toInt( &ok );
+
+            if ( ok )
+                customValues << value;
+        }
+
+        return LayerTemplate( Settings::tr( "Custom" ), customValues );
+    }
+
+    case NoTemplate:
+    case TemplateCount:
+        break;
+    }
+
+    return LayerTemplate();
+}
+
+/**
+ * @brief Settings::writerOptions returns writer options from current settings
+ * @return
+ */
+WriterOptions Settings::writerOptions() {
+    return Settings::writerOptions( *Variable::instance()->snapshot());
+}
+
+/**
+ * @brief Settings::writerOptions returns writer options from a settings snapshot
+ * @param settings
+ * @return
+ */
+WriterOptions Settings::writerOptions( const VariableSnapshot &settings ) {
+    return WriterOptions( Settings_::MacOS.value( settings ), Settings_::LegacyICNS.value( settings ));
+}
+
+/**
+ * @brief Settings::layerSetOptions returns layer generation options from current settings
+ * @return
+ */
+LayerSetOptions Settings::layerSetOptions() {
+    return Settings::layerSetOptions( *Variable::instance()->snapshot());
+}
+
+/**
+ * @brief Settings::layerSetOptions returns layer generation options from a settings snapshot
+ * @param settings
+ * @return
+ */
+LayerSetOptions Settings::layerSetOptions( const VariableSnapshot &settings ) {
+    return LayerSetOptions( Settings::layerTemplate( static_cast<Templates>( Settings_::Template.value( settings )), settings ).scales,
+                            Settings_::MacOS.value( settings ),
+                            Settings_::Compress.value( settings ),
+                            Settings_::CompressThreshold.value( settings ));
+}
+
+/**
+ * @brief Settings::registerVariables adds settings variables and resolves their handles
+ */
+void Settings::registerVariables() {
+    Settings_::Template = Variable::instance()->addSetting<int>( "settings/layerTemplate", Settings::Windows7 );
+    Settings_::CustomTemplate = Variable::instance()->addSetting<QString>( "settings/customTemplate", "16,32,48,64,256" );
+    Settings_::CompressThreshold = Variable::instance()->addSetting<int>( "settings/compressThreshold", IconFormat::ThresholdScale );
+    Settings_::Compress = Variable::instance()->addSetting<bool>( "settings/compress", true );
+    Settings_::MacOS = Variable::instance()->addSetting<bool>( "settings/macOS", false );
+    Settings_::LegacyICNS = Variable::instance()->addSetting<bool>( "settings/legacyICNS", true );
+    Settings_::SizeBudget = Variable::instance()->addSetting<int>( "settings/sizeBudget", 0 );
+}
+
 /**
  * @brief Settings::~Settings
  */
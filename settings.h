@@ -23,6 +23,9 @@
 //
 #include <QDialog>
 #include <QMap>
+#include "iconwriter.h"
+#include "layerset.h"
+#include "variable.h"
 
 /**
  * @brief The Ui namespace
@@ -31,6 +34,19 @@ namespace Ui {
 class Settings;
 }
 
+/**
+ * @brief The Settings_ namespace holds typed handles to registered settings
+ */
+namespace Settings_ {
+    extern Setting<int> Template;
+    extern Setting<QString> CustomTemplate;
+    extern Setting<int> CompressThreshold;
+    extern Setting<bool> Compress;
+    extern Setting<bool> MacOS;
+    extern Setting<bool> LegacyICNS;
+    extern Setting<int> SizeBudget;
+}
+
 /**
  * @brief The LayerTemplate struct
  */
@@ -63,6 +79,13 @@ public:
     explicit Settings( QWidget *parent = nullptr );
     ~Settings();
     QList<int> currentScales() const;
+    static LayerTemplate layerTemplate( Templates index );
+    static LayerTemplate layerTemplate( Templates index, const VariableSnapshot &settings );
+    static WriterOptions writerOptions();
+    static WriterOptions writerOptions( const VariableSnapshot &settings );
+    static LayerSetOptions layerSetOptions();
+    static LayerSetOptions layerSetOptions( const VariableSnapshot &settings );
+    static void registerVariables();
 
 private:
     Ui::Settings *ui;
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+//
+// includes
+//
+#include "sizeestimator.h"
+#include "trace.h"
+
+/**
+ * @brief SizeEstimator::key identifies an entry by pixels, encoding and format
+ * @param layer
+ * @return
+ */
+QString SizeEstimator::key( const Layer *layer ) const {
+    return QString( "%1:%2:%3:%4:%5:%6" )
+            .arg( layer->generation())
+            .arg( static_cast<int>( layer->encoding()))
+            .arg( layer->scale())
+            .arg( layer->isDoubleScale())
+            .arg( this->m_writer.options().macOS )
+            .arg( this->m_writer.options().legacy );
+}
+
+/**
+ * @brief SizeEstimator::entrySize encodes a single entry (analytic for bitmaps)
+ * @param layer
+ * @return
+ */
+qint64 SizeEstimator::entrySize( const Layer *layer ) const {
+    // imported entries are not decoded just for an estimate, their stored size
+    // stands in (plus the icns record header)
+    if ( layer->storedBytes() > 0 )
+        return layer->storedBytes() + ( this->m_writer.options().macOS ? 8 : 0 );
+
+    if ( this->m_writer.options().macOS )
+        return this->m_writer.icnsData( layer, this->m_writer.options().legacy ).size();
+
+    return this->m_writer.iconDirectory( layer->image(), layer->encoding()).bytes;
+}
+
+/**
+ * @brief SizeEstimator::estimate
+ * @param layers
+ * @return total file size in bytes
+ */
+qint64 SizeEstimator::estimate( const QList<Layer*> &layers ) {
+    const TraceScope trace( "SizeEstimator::estimate" );
+    QHash<QString, qint64> sizes;
+    qint64 total = this->m_writer.options().macOS ? 8 : static_cast<qint64>( sizeof( IcoHeader ));
+
+    this->m_encoded = 0;
+    foreach ( const Layer *layer, layers ) {
+        const QString key( this->key( layer ));
+
+        if ( !sizes.contains( key )) {
+            if ( this->m_sizes.contains( key )) {
+                sizes[key] = this->m_sizes[key];
+            } else {
+                sizes[key] = this->entrySize( layer );
+                this->m_encoded++;
+            }
+        }
+
+        total += sizes[key];
+        if ( !this->m_writer.options().macOS )
+            total += static_cast<qint64>( sizeof( IcoDirectory ));
+    }
+
+    // keep only entries of the current layer set
+    this->m_sizes = sizes;
+
+    return total;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+#pragma once
+
+//
+// includes
+//
+#include <QHash>
+#include <QList>
+#include "iconwriter.h"
+#include "layer.h"
+
+/**
+ * @brief The SizeEstimator class estimates the written icon size, re-encoding only changed layers
+ *
+ * Entry sizes are cached by pixel generation (Layer::generation, which is
+ * renewed whenever a layer's image is replaced), encoding and format.
+ * Imported entries that are still untouched use their stored size, so they
+ * are not decoded. An estimator must not be used by more than one thread at
+ * a time.
+ */
+class SizeEstimator final {
+public:
+    explicit SizeEstimator( const WriterOptions &options = WriterOptions()) : m_writer( options ), m_encoded( 0 ) {}
+    ~SizeEstimator() = default;
+    void setOptions( const WriterOptions &options ) { this->m_writer.setOptions( options ); }
+    qint64 estimate( const QList<Layer*> &layers );
+    int encoded() const { return this->m_encoded; }
+
+private:
+    QString key( const Layer *layer ) const;
+    qint64 entrySize( const Layer *layer ) const;
+    IconWriter m_writer;
+    QHash<QString, qint64> m_sizes;
+    int m_encoded;
+};
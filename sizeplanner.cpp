@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "sizeplanner.h"
+#include "iconwriter.h"
+#include <algorithm>
+
+/**
+ * @brief SizePlanner::measure finds the cheapest lossless encoding of a layer
+ * @param layer
+ * @return
+ */
+SizePlanner::Candidate SizePlanner::measure( Layer *layer ) {
+    const QImage image( layer->image().convertToFormat( QImage::Format_ARGB32 ));
+    Candidate candidate( layer );
+    bool exact = false;
+
+    // icns entries are png or legacy rle, whichever the writer finds smaller
+    if ( this->m_macOS ) {
+        candidate.encoding = Layer::Encodings::PNG;
+        candidate.bytes = this->m_writer.icnsData( layer, this->m_legacy, &this->m_payloads ).size();
+        return candidate;
+    }
+
+    if ( this->m_allowPNG ) {
+        candidate.encoding = Layer::Encodings::PNG;
+        candidate.bytes = this->m_writer.iconData( image, Layer::Encodings::PNG ).size();
+    }
+
+    // bitmap size is known upfront
+    const qint64 bitmap = IconWriter::bitmapSize( image.width(), image.height());
+    if ( candidate.encoding == Layer::Encodings::NoEncoding || bitmap < candidate.bytes ) {
+        candidate.encoding = Layer::Encodings::Bitmap;
+        candidate.bytes = bitmap;
+    }
+
+    // palette is lossless only for binary alpha and at most 256 colours
+    const QImage indexed( IconWriter::toPalette( image, &exact ));
+    const qint64 palette = IconWriter::bitmapSize( image.width(), image.height(), indexed.colorCount());
+    if ( exact && palette < candidate.bytes ) {
+        candidate.encoding = Layer::Encodings::Palette;
+        candidate.bytes = palette;
+    }
+
+    // quantized palette is the degraded fallback
+    if ( !exact )
+        candidate.degradedBytes = palette;
+
+    return candidate;
+}
+
+/**
+ * @brief SizePlanner::plan assigns an encoding to every layer
+ * @param layers
+ * @return total estimated file size
+ */
+qint64 SizePlanner::plan( const QList<Layer*> &layers ) {
+    QList<Candidate> candidates;
+
+    // icon header and directory
+    this->m_total = this->m_macOS ? 8 : static_cast<qint64>( sizeof( IcoHeader ) + sizeof( IcoDirectory ) * static_cast<size_t>( layers.count()));
+
+    foreach ( Layer *layer, layers ) {
+        const Candidate candidate( this->measure( layer ));
+
+        this->m_total += candidate.bytes;
+        candidates << candidate;
+    }
+
+    // degrade the largest entries first until budget is met
+    if ( !this->isWithinBudget()) {
+        std::sort( candidates.begin(), candidates.end(), []( const Candidate &one, const Candidate &two ) { return one.bytes > two.bytes; } );
+
+        for ( int y = 0; y < candidates.count() && !this->isWithinBudget(); y++ ) {
+            Candidate &candidate = candidates[y];
+
+            if ( candidate.degradedBytes <= 0 || candidate.degradedBytes >= candidate.bytes )
+                continue;
+
+            this->m_total -= candidate.bytes - candidate.degradedBytes;
+            candidate.encoding = Layer::Encodings::Palette;
+            candidate.bytes = candidate.degradedBytes;
+        }
+    }
+
+    // store decisions
+    foreach ( const Candidate &candidate, candidates )
+        candidate.layer->setEncoding( candidate.encoding, candidate.bytes );
+
+    return this->m_total;
+}
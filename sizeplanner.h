@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QHash>
+#include <QList>
+#include "iconwriter.h"
+#include "layer.h"
+
+/**
+ * @brief The SizePlanner class picks the cheapest encoding for each layer
+ */
+class SizePlanner final {
+public:
+    explicit SizePlanner( qint64 budget = 0, bool macOS = false, bool allowPNG = true, bool legacy = false ) : m_budget( budget ), m_macOS( macOS ), m_allowPNG( allowPNG ), m_legacy( legacy ), m_total( 0 ), m_writer( WriterOptions( macOS, legacy )) {}
+    ~SizePlanner() = default;
+    qint64 plan( const QList<Layer*> &layers );
+    qint64 budget() const { return this->m_budget; }
+    qint64 total() const { return this->m_total; }
+    bool isWithinBudget() const { return this->m_budget <= 0 || this->m_total <= this->m_budget; }
+
+private:
+    /**
+     * @brief The Candidate struct
+     */
+    struct Candidate {
+        Layer *layer;
+        Layer::Encodings encoding;
+        qint64 bytes;
+        qint64 degradedBytes;
+        Candidate( Layer *l = nullptr ) : layer( l ), encoding( Layer::Encodings::NoEncoding ), bytes( 0 ), degradedBytes( 0 ) {}
+    };
+    Candidate measure( Layer *layer );
+    qint64 m_budget;
+    bool m_macOS;
+    bool m_allowPNG;
+    bool m_legacy;
+    qint64 m_total;
+    QHash<QByteArray, QByteArray> m_payloads;
+    IconWriter m_writer;
+};
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+#pragma once
+
+//
+// includes
+//
+#include <QFile>
+#include <cstdio>
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+/**
+ * @brief The StandardOutput namespace (shared by the core library, command line and client)
+ */
+namespace StandardOutput {
+/**
+ * @brief open opens stdout for binary output
+ * @param file
+ * @return
+ *
+ * Windows opens stdout in text mode, which would expand every 0x0a byte
+ * of an icon into CRLF.
+ */
+inline static bool open( QFile &file ) {
+#ifdef Q_OS_WIN
+    _setmode( _fileno( stdout ), _O_BINARY );
+#endif
+    return file.open( stdout, QIODevice::WriteOnly );
+}
+}
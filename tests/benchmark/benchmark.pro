@@ -0,0 +1,31 @@
+#-------------------------------------------------
+#
+# Icon pipeline benchmarks (QtTest)
+#
+#-------------------------------------------------
+
+QT       += core gui concurrent network widgets testlib
+CONFIG  += testcase console
+CONFIG  -= app_bundle
+
+TARGET = tst_benchmark
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# link against the core library (built in the top level build directory)
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../../release/ -lburningicon
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../../debug/ -lburningicon
+else:unix: LIBS += -L$$OUT_PWD/../../ -lburningicon
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../../release/libburningicon.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../../debug/libburningicon.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../../release/burningicon.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../../debug/burningicon.lib
+else:unix: PRE_TARGETDEPS += $$OUT_PWD/../../libburningicon.a
+
+# application sources (templates, layers and scene export)
+include(../../app.pri)
+
+SOURCES += \
+    tst_benchmark.cpp
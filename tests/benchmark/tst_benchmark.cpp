@@ -0,0 +1,542 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+//
+// includes
+//
+#include "designer.h"
+#include "iconsource.h"
+#include "iconwriter.h"
+#include "imagelayer.h"
+#include "layerset.h"
+#include "settings.h"
+#include "shapelayer.h"
+#include "textlayer.h"
+#include <QBuffer>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QGraphicsScene>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QPainter>
+#include <QRadialGradient>
+#include <QSaveFile>
+#include <QtTest>
+#include <algorithm>
+
+/**
+ * @brief The Benchmark_ namespace
+ */
+namespace Benchmark_ {
+const static QLoggingCategory Debug( "benchmark" );
+constexpr double DefaultThreshold = 10.0;
+static const QList<int> SourceScales = QList<int>() << 64 << 512 << 2048 << 8192;
+static const QList<int> LayerScales = QList<int>() << 16 << 256 << 1024;
+
+// environment (real-world corpus, results and baseline)
+static const char *FilesVariable = "BURNINGICON_BENCHMARK_FILES";
+static const char *OutputVariable = "BURNINGICON_BENCHMARK_OUTPUT";
+static const char *BaselineVariable = "BURNINGICON_BENCHMARK_BASELINE";
+static const char *ThresholdVariable = "BURNINGICON_BENCHMARK_THRESHOLD";
+static const QString DefaultOutput( "benchmark.json" );
+}
+
+/**
+ * @brief The Benchmark class times the icon pipeline on synthetic and real-world images
+ */
+class Benchmark final : public QObject {
+    Q_OBJECT
+
+public:
+    enum class Corpora {
+        NoCorpus = -1,
+        Logo,
+        Photo,
+        Alpha,
+        Svg,
+        File
+    };
+    Q_ENUM( Corpora )
+    static QImage flatLogo( int scale );
+    static QImage photo( int scale );
+    static QImage alphaArt( int scale );
+    static QByteArray svg();
+
+private slots:
+    void initTestCase();
+    void fit_data() { this->addCorpora(); }
+    void fit();
+    void layer_data();
+    void layer();
+    void generateLayers_data();
+    void generateLayers();
+    void writeIco_data() { this->addCorpora(); }
+    void writeIco();
+    void writeIcns_data() { this->addCorpora(); }
+    void writeIcns();
+    void decode_data();
+    void decode();
+    void designerExport();
+    void cleanupTestCase();
+
+private:
+    void addCorpora( const QStringList &suffixes = QStringList()) const;
+    static QImage corpusImage();
+    void record( qint64 nanoseconds );
+    QJsonDocument toJson() const;
+    int compare( const QJsonDocument &baseline, double threshold ) const;
+    QStringList files;
+    QMap<QString, QList<qint64>> samples;
+};
+
+/**
+ * @brief Benchmark::flatLogo generates a few solid shapes (compresses well, few colours)
+ * @param scale
+ * @return
+ */
+QImage Benchmark::flatLogo( int scale ) {
+    QImage image( scale, scale, QImage::Format_ARGB32_Premultiplied );
+    QPainter painter( &image );
+
+    image.fill( Qt::transparent );
+    painter.setRenderHint( QPainter::Antialiasing );
+    painter.setPen( Qt::NoPen );
+    painter.setBrush( QColor( 0xd0, 0x3a, 0x2f ));
+    painter.drawEllipse( QRectF( 0, 0, scale, scale ));
+    painter.setBrush( Qt::white );
+    painter.drawRect( QRectF( scale * 0.3, scale * 0.3, scale * 0.4, scale * 0.4 ));
+    painter.end();
+
+    return image;
+}
+
+/**
+ * @brief Benchmark::photo generates opaque gradients with noise (incompressible, many colours)
+ * @param scale
+ * @return
+ */
+QImage Benchmark::photo( int scale ) {
+    QImage image( scale, scale, QImage::Format_RGB32 );
+    quint32 seed = 0x12345678;
+
+    for ( int y = 0; y < scale; y++ ) {
+        QRgb *line = reinterpret_cast<QRgb*>( image.scanLine( y ));
+
+        for ( int x = 0; x < scale; x++ ) {
+            // xorshift noise on top of a diagonal gradient
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+
+            const int noise = static_cast<int>( seed & 0x1f ) - 16;
+            line[x] = qRgb( qBound( 0, x * 255 / scale + noise, 255 ), qBound( 0, y * 255 / scale + noise, 255 ), qBound( 0, ( x + y ) * 127 / scale - noise, 255 ));
+        }
+    }
+
+    return image;
+}
+
+/**
+ * @brief Benchmark::alphaArt generates soft overlapping translucent glows
+ * @param scale
+ * @return
+ */
+QImage Benchmark::alphaArt( int scale ) {
+    QImage image( scale, scale, QImage::Format_ARGB32_Premultiplied );
+    QPainter painter( &image );
+    const QList<QColor> colours = QList<QColor>() << QColor( 255, 80, 0 ) << QColor( 0, 160, 255 ) << QColor( 120, 255, 60 );
+
+    image.fill( Qt::transparent );
+    painter.setRenderHint( QPainter::Antialiasing );
+    painter.setPen( Qt::NoPen );
+
+    for ( int y = 0; y < colours.count(); y++ ) {
+        const QPointF centre( scale * ( 0.3 + 0.2 * y ), scale * ( 0.35 + 0.15 * y ));
+        QRadialGradient gradient( centre, scale * 0.45 );
+        QColor transparent( colours.at( y ));
+
+        transparent.setAlpha( 0 );
+        gradient.setColorAt( 0.0, colours.at( y ));
+        gradient.setColorAt( 1.0, transparent );
+        painter.setBrush( gradient );
+        painter.drawRect( image.rect());
+    }
+    painter.end();
+
+    return image;
+}
+
+/**
+ * @brief Benchmark::svg returns a vector logo with gradients and text-like paths
+ * @return
+ */
+QByteArray Benchmark::svg() {
+    QByteArray bytes( "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"0 0 100 100\">"
+                      "<defs><linearGradient id=\"g\"><stop offset=\"0\" stop-color=\"#f80\"/><stop offset=\"1\" stop-color=\"#08f\" stop-opacity=\"0.5\"/></linearGradient></defs>"
+                      "<circle cx=\"50\" cy=\"50\" r=\"48\" fill=\"url(#g)\" stroke=\"#222\" stroke-width=\"2\"/>" );
+
+    // many small curves, similar to converted lettering
+    for ( int y = 0; y < 64; y++ )
+        bytes.append( QString( "<path d=\"M%1 %2 q4 -8 8 0 t8 0\" fill=\"none\" stroke=\"#fff\" stroke-opacity=\"0.6\"/>" ).arg( 10 + ( y % 8 ) * 10 ).arg( 15 + ( y / 8 ) * 10 ).toLatin1());
+
+    bytes.append( "</svg>" );
+    return bytes;
+}
+
+/**
+ * @brief Benchmark::initTestCase registers settings (defaults only) and reads the real-world corpus
+ */
+void Benchmark::initTestCase() {
+    Settings::registerVariables();
+
+    const QString files( qEnvironmentVariable( Benchmark_::FilesVariable ));
+    if ( !files.isEmpty())
+        this->files = files.split( QDir::listSeparator(), QString::SkipEmptyParts );
+}
+
+/**
+ * @brief Benchmark::addCorpora adds a data row per source image (and per suffix, if any)
+ * @param suffixes
+ */
+void Benchmark::addCorpora( const QStringList &suffixes ) const {
+    const QStringList tags( suffixes.isEmpty() ? QStringList() << QString() : suffixes );
+
+    QTest::addColumn<Corpora>( "corpus" );
+    QTest::addColumn<int>( "scale" );
+    QTest::addColumn<QString>( "fileName" );
+    QTest::addColumn<int>( "index" );
+
+    for ( int y = 0; y < tags.count(); y++ ) {
+        const QString suffix( tags.at( y ).isEmpty() ? QString() : "/" + tags.at( y ));
+
+        // synthetic corpora (generated one row at a time, 8k sources take 256 MiB each)
+        foreach ( const int scale, Benchmark_::SourceScales ) {
+            QTest::newRow( qPrintable( QString( "logo/%1%2" ).arg( scale ).arg( suffix ))) << Corpora::Logo << scale << QString() << y;
+            QTest::newRow( qPrintable( QString( "photo/%1%2" ).arg( scale ).arg( suffix ))) << Corpora::Photo << scale << QString() << y;
+            QTest::newRow( qPrintable( QString( "alpha/%1%2" ).arg( scale ).arg( suffix ))) << Corpora::Alpha << scale << QString() << y;
+        }
+
+        // svgs are pre-rendered to maximum scale on load
+        QTest::newRow( qPrintable( "svg" + suffix )) << Corpora::Svg << 0 << QString() << y;
+
+        // real-world corpus
+        foreach ( const QString &fileName, this->files )
+            QTest::newRow( qPrintable( "file/" + QFileInfo( fileName ).fileName() + suffix )) << Corpora::File << 0 << fileName << y;
+    }
+}
+
+/**
+ * @brief Benchmark::corpusImage generates or loads the source image of the current data row
+ * @return
+ */
+QImage Benchmark::corpusImage() {
+    QFETCH( Corpora, corpus );
+    QFETCH( int, scale );
+    QFETCH( QString, fileName );
+
+    switch ( corpus ) {
+    case Corpora::Logo:
+        return Benchmark::flatLogo( scale );
+
+    case Corpora::Photo:
+        return Benchmark::photo( scale );
+
+    case Corpora::Alpha:
+        return Benchmark::alphaArt( scale );
+
+    case Corpora::Svg:
+        return IconSource::fromData( Benchmark::svg()).image();
+
+    case Corpora::File:
+        return IconSource::decode( fileName );
+
+    case Corpora::NoCorpus:
+        break;
+    }
+
+    return QImage();
+}
+
+/**
+ * @brief Benchmark::record stores the time of a single iteration of the current data row
+ * @param nanoseconds
+ */
+void Benchmark::record( qint64 nanoseconds ) {
+    const QString tag( QTest::currentDataTag());
+    const QString name( tag.isEmpty() ? QString( QTest::currentTestFunction()) : QString( "%1/%2" ).arg( QTest::currentTestFunction()).arg( tag ));
+
+    this->samples[name] << nanoseconds;
+}
+
+/**
+ * @brief Benchmark::fit times fitting to maximum layer scale
+ */
+void Benchmark::fit() {
+    const QImage image( Benchmark::corpusImage());
+    QVERIFY( !image.isNull());
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+
+        timer.start();
+        const IconSource source( image );
+        this->record( timer.nsecsElapsed());
+    }
+}
+
+/**
+ * @brief Benchmark::layer_data
+ */
+void Benchmark::layer_data() {
+    QStringList suffixes;
+
+    foreach ( const int scale, Benchmark_::LayerScales )
+        suffixes << QString::number( scale );
+
+    this->addCorpora( suffixes );
+}
+
+/**
+ * @brief Benchmark::layer times scaling a single layer
+ */
+void Benchmark::layer() {
+    QFETCH( int, index );
+    const IconSource source( Benchmark::corpusImage());
+    const int scale = Benchmark_::LayerScales.at( index );
+    QVERIFY( !source.image().isNull());
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+
+        timer.start();
+        const Layer layer( source.image(), scale );
+        this->record( timer.nsecsElapsed());
+    }
+}
+
+/**
+ * @brief Benchmark::generateLayers_data
+ */
+void Benchmark::generateLayers_data() {
+    QStringList suffixes;
+
+    for ( int y = 0; y < Settings::TemplateCount; y++ )
+        suffixes << Settings::layerTemplate( static_cast<Settings::Templates>( y )).name;
+
+    this->addCorpora( suffixes );
+}
+
+/**
+ * @brief Benchmark::generateLayers times layer generation for every template
+ */
+void Benchmark::generateLayers() {
+    QFETCH( int, index );
+    const IconSource source( Benchmark::corpusImage());
+    const LayerTemplate layerTemplate( Settings::layerTemplate( static_cast<Settings::Templates>( index )));
+    const LayerSetOptions options( layerTemplate.scales, layerTemplate.macOS );
+    QVERIFY( !source.image().isNull());
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+
+        timer.start();
+        const LayerSet layers( source, options );
+        this->record( timer.nsecsElapsed());
+    }
+}
+
+/**
+ * @brief Benchmark::writeIco times ico encoding
+ */
+void Benchmark::writeIco() {
+    const IconSource source( Benchmark::corpusImage());
+    const LayerSet layers( source, LayerSetOptions( Settings::layerTemplate( Settings::Windows7 ).scales ));
+    QVERIFY( !source.image().isNull());
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+        QBuffer buffer;
+
+        timer.start();
+        buffer.open( QIODevice::WriteOnly );
+        IconWriter( WriterOptions( false )).write( &buffer, layers.layers());
+        this->record( timer.nsecsElapsed());
+    }
+}
+
+/**
+ * @brief Benchmark::writeIcns times icns encoding
+ */
+void Benchmark::writeIcns() {
+    const IconSource source( Benchmark::corpusImage());
+    const LayerSet layers( source, LayerSetOptions( QList<int>(), true ));
+    QVERIFY( !source.image().isNull());
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+        QBuffer buffer;
+
+        timer.start();
+        buffer.open( QIODevice::WriteOnly );
+        IconWriter( WriterOptions( true )).write( &buffer, layers.layers());
+        this->record( timer.nsecsElapsed());
+    }
+}
+
+/**
+ * @brief Benchmark::decode_data
+ */
+void Benchmark::decode_data() {
+    QTest::addColumn<QString>( "fileName" );
+
+    // empty file name decodes the built-in svg
+    QTest::newRow( "svg" ) << QString();
+    foreach ( const QString &fileName, this->files )
+        QTest::newRow( qPrintable( "file/" + QFileInfo( fileName ).fileName())) << fileName;
+}
+
+/**
+ * @brief Benchmark::decode times loading (and svg rendering) of source images
+ */
+void Benchmark::decode() {
+    QFETCH( QString, fileName );
+    const QByteArray svg( Benchmark::svg());
+    QImage image;
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+
+        timer.start();
+        image = fileName.isEmpty() ? IconSource::fromData( svg ).image() : IconSource::decode( fileName );
+        this->record( timer.nsecsElapsed());
+    }
+
+    QVERIFY2( !image.isNull(), qPrintable( QString( "could not read \"%1\"" ).arg( fileName )));
+}
+
+/**
+ * @brief Benchmark::designerExport times export of a typical composition
+ */
+void Benchmark::designerExport() {
+    QGraphicsScene scene( QRectF( 0, 0, 256, 256 ));
+    QList<DesignerLayer*> layers;
+
+    layers << new ShapeLayer( &scene, ShapeLayer::Shapes::Ellipse );
+    layers << new ImageLayer( &scene, QPixmap::fromImage( Benchmark::photo( 512 )));
+    layers << new ShapeLayer( &scene, ShapeLayer::Shapes::Rectangle );
+    layers << new TextLayer( &scene, "Aa" );
+    foreach ( DesignerLayer *layer, layers )
+        layer->adjust();
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+
+        timer.start();
+        Designer::renderScene( &scene );
+        this->record( timer.nsecsElapsed());
+    }
+
+    qDeleteAll( layers );
+}
+
+/**
+ * @brief Benchmark::toJson writes the median time of every benchmark
+ * @return
+ */
+QJsonDocument Benchmark::toJson() const {
+    QJsonObject root;
+    QJsonArray array;
+
+    foreach ( const QString &name, this->samples.keys()) {
+        QList<qint64> times( this->samples[name] );
+        QJsonObject object;
+
+        std::sort( times.begin(), times.end());
+        object["name"] = name;
+        object["nanoseconds"] = static_cast<double>( times.at( times.count() / 2 ));
+        object["iterations"] = times.count();
+        array << object;
+    }
+
+    root["results"] = array;
+
+    return QJsonDocument( root );
+}
+
+/**
+ * @brief Benchmark::compare flags results slower than baseline by more than threshold
+ * @param baseline document written by an earlier run
+ * @param threshold percent
+ * @return number of regressions
+ */
+int Benchmark::compare( const QJsonDocument &baseline, double threshold ) const {
+    QHash<QString, double> reference;
+    int regressions = 0;
+
+    foreach ( const QJsonValue &value, baseline.object().value( "results" ).toArray()) {
+        const QJsonObject object( value.toObject());
+        reference[object.value( "name" ).toString()] = object.value( "nanoseconds" ).toDouble();
+    }
+
+    foreach ( const QJsonValue &value, this->toJson().object().value( "results" ).toArray()) {
+        const QJsonObject object( value.toObject());
+        const QString name( object.value( "name" ).toString());
+
+        if ( !reference.contains( name ) || reference[name] <= 0.0 )
+            continue;
+
+        const double change = ( object.value( "nanoseconds" ).toDouble() / reference[name] - 1.0 ) * 100.0;
+        if ( change > threshold ) {
+            qCWarning( Benchmark_::Debug ).noquote() << QString( "regression: %1 %2% slower" ).arg( name ).arg( change, 0, 'f', 1 );
+            regressions++;
+        }
+    }
+
+    return regressions;
+}
+
+/**
+ * @brief Benchmark::cleanupTestCase writes results and compares them against a stored baseline
+ */
+void Benchmark::cleanupTestCase() {
+    const QString output( qEnvironmentVariableIsSet( Benchmark_::OutputVariable ) ? qEnvironmentVariable( Benchmark_::OutputVariable ) : Benchmark_::DefaultOutput );
+    const QByteArray json( this->toJson().toJson());
+    QSaveFile file( output );
+
+    QVERIFY2( file.open( QIODevice::WriteOnly ) && file.write( json ) == json.size() && file.commit(), qPrintable( QString( "could not write results \"%1\"" ).arg( output )));
+
+    // flag regressions against baseline
+    if ( !qEnvironmentVariableIsSet( Benchmark_::BaselineVariable ))
+        return;
+
+    QFile baseline( qEnvironmentVariable( Benchmark_::BaselineVariable ));
+    QVERIFY2( baseline.open( QIODevice::ReadOnly ), qPrintable( QString( "could not read baseline \"%1\"" ).arg( baseline.fileName())));
+
+    bool ok;
+    double threshold = qEnvironmentVariable( Benchmark_::ThresholdVariable ).toDouble( &ok );
+    if ( !ok )
+        threshold = Benchmark_::DefaultThreshold;
+
+    const int regressions = this->compare( QJsonDocument::fromJson( baseline.readAll()), threshold );
+    QVERIFY2( regressions == 0, qPrintable( QString( "%1 regression(s)" ).arg( regressions )));
+}
+
+QTEST_MAIN( Benchmark )
+#include "tst_benchmark.moc"
@@ -0,0 +1,10 @@
+#-------------------------------------------------
+#
+# Test and benchmark targets (run with make check)
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS = \
+    benchmark
@@ -20,13 +20,16 @@
 // includes
 //
 #include "textlayer.h"
+#include "glyphcache.h"
 
 /**
  * @brief TextLayer::TextLayer
  */
 TextLayer::TextLayer( QGraphicsScene *scene, const QString &text ) :
     DesignerLayer( scene ),
-    textItem( nullptr )
+    pathItem( nullptr ),
+    m_text( text ),
+    textScale( 1.0 )
 {
 
     if ( this->scene() == nullptr )
@@ -35,9 +38,8 @@ TextLayer::TextLayer( QGraphicsScene *scene, const QString &text ) :
     DesignerLayer::setName( this->tr( "Text layer" ));
     DesignerLayer::setType( DesignerLayer::Types::Text );
     this->font.setPointSize( TextItem::DefaultPointSize );
-    this->textItem = this->scene()->addText( text );
-    this->textItem->setFont( this->font );
-    this->textItem->setDefaultTextColor( Qt::white );
+    this->pathItem = this->scene()->addPath( QPainterPath(), Qt::NoPen, QBrush( Qt::white ));
+    this->updateOutline();
 }
 
 /**
@@ -45,7 +47,15 @@ TextLayer::TextLayer( QGraphicsScene *scene, const QString &text ) :
  * @return
  */
 QGraphicsItem *TextLayer::item() {
-    return dynamic_cast<QGraphicsItem*>( this->textItem );
+    return dynamic_cast<QGraphicsItem*>( this->pathItem );
+}
+
+/**
+ * @brief TextLayer::colour
+ * @return
+ */
+QColor TextLayer::colour() const {
+    return this->pathItem == nullptr ? QColor( Qt::white ) : this->pathItem->brush().color();
 }
 
 /**
@@ -53,23 +63,71 @@ QGraphicsItem *TextLayer::item() {
  * @param scale
  */
 void TextLayer::setScale( qreal scale ) {
-    if ( this->item() == nullptr )
+    this->textScale = scale;
+    this->setPointSize( qMax( TextItem::MinimumPointSize, static_cast<int>( TextItem::DefaultPointSize * scale )));
+}
+
+/**
+ * @brief TextLayer::setText
+ * @param text
+ */
+void TextLayer::setText( const QString &text ) {
+    this->m_text = text;
+    this->updateOutline();
+}
+
+/**
+ * @brief TextLayer::setFont
+ * @param font
+ */
+void TextLayer::setFont( const QFont &font ) {
+    this->font = font;
+    this->updateOutline();
+}
+
+/**
+ * @brief TextLayer::setPointSize scales the outline (no relayout)
+ * @param pointSize
+ */
+void TextLayer::setPointSize( int pointSize ) {
+    this->font.setPointSize( pointSize );
+
+    if ( this->pathItem != nullptr )
+        this->pathItem->setScale( this->font.pointSizeF() / TextItem::DefaultPointSize );
+}
+
+/**
+ * @brief TextLayer::setColour
+ * @param colour
+ */
+void TextLayer::setColour( const QColor &colour ) {
+    if ( this->pathItem != nullptr )
+        this->pathItem->setBrush( colour );
+}
+
+/**
+ * @brief TextLayer::updateOutline fetches the outline shaped at the default point size
+ */
+void TextLayer::updateOutline() {
+    QFont reference( this->font );
+
+    if ( this->pathItem == nullptr )
         return;
 
-    this->font.setPointSize( qMax( TextItem::MinimumPointSize, static_cast<int>( TextItem::DefaultPointSize * scale )));
-    this->textItem->setFont( this->font );
+    reference.setPointSize( TextItem::DefaultPointSize );
+    this->pathItem->setPath( GlyphCache::outline( reference, this->m_text ));
+    this->pathItem->setScale( this->font.pointSizeF() / TextItem::DefaultPointSize );
 }
 
 /**
- * @brief TextLayer::adjust
+ * @brief TextLayer::adjust centres the outline (bounds are cached by the item)
  */
 void TextLayer::adjust() {
     if ( this->item() == nullptr )
         return;
 
+    const QPointF centre( this->pathItem->boundingRect().center() * this->pathItem->scale());
     this->item()->setPos(
-                this->scene()->sceneRect().width() / 2.0 -
-                this->item()->sceneBoundingRect().width() / 2.0 + this->horizontalOffset(),
-                this->scene()->sceneRect().height() / 2.0 -
-                this->item()->sceneBoundingRect().height() / 2.0 + this->verticalOffset());
+                this->scene()->sceneRect().width() / 2.0 - centre.x() + this->horizontalOffset(),
+                this->scene()->sceneRect().height() / 2.0 - centre.y() + this->verticalOffset());
 }
@@ -23,7 +23,7 @@
 //
 #include "designerlayer.h"
 #include <QGraphicsScene>
-#include <QGraphicsTextItem>
+#include <QGraphicsPathItem>
 
 /**
  * @brief The TextItem namespace
@@ -35,6 +35,9 @@ static constexpr int DefaultPointSize = 96;
 
 /**
  * @brief The ImageLayer class
+ *
+ * Text is drawn from cached glyph outlines shaped at the default point size;
+ * point size changes only scale the item.
  */
 class TextLayer final : public DesignerLayer {
     Q_OBJECT
@@ -44,11 +47,21 @@ public:
     TextLayer( QGraphicsScene *scene = nullptr, const QString &text = QString());
     QGraphicsItem *item() override;
     void adjust() override;
+    qreal scale() const override { return this->textScale; }
+    QString text() const { return this->m_text; }
+    QColor colour() const;
 
 public slots:
     void setScale( qreal scale ) override;
+    void setText( const QString &text );
+    void setFont( const QFont &font );
+    void setPointSize( int pointSize );
+    void setColour( const QColor &colour );
 
 private:
-    QGraphicsTextItem *textItem;
+    void updateOutline();
+    QGraphicsPathItem *pathItem;
+    QString m_text;
     QFont font;
+    qreal textScale;
 };
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+//
+// includes
+//
+#include "trace.h"
+#include <QCoreApplication>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+
+/**
+ * @brief Trace::Trace
+ */
+Trace::Trace() : m_enabled( false ), m_log( Trace_::Debug().isDebugEnabled()), m_fileName( QString::fromLocal8Bit( qgetenv( Trace_::EnvironmentVariable ))) {
+    this->m_enabled = this->m_log || !this->m_fileName.isEmpty() || !qEnvironmentVariableIsEmpty( Trace_::StagesVariable );
+    this->m_timer.start();
+}
+
+/**
+ * @brief Trace::add records a completed stage
+ * @param name
+ * @param start
+ * @param duration
+ */
+void Trace::add( const char *name, qint64 start, qint64 duration, quint64 allocations ) {
+    const Event event = { name, start, duration, reinterpret_cast<quintptr>( QThread::currentThreadId()), allocations };
+
+    if ( this->m_log )
+        qCDebug( Trace_::Debug ) << name << QString( "%1 ms" ).arg( static_cast<double>( duration ) / 1000000.0, 0, 'f', 3 );
+
+    QMutexLocker locker( &this->m_mutex );
+
+    // accumulate per-stage totals (keyed by content, equal names may be
+    // distinct literals in different translation units)
+    const QByteArray key( QByteArray::fromRawData( name, static_cast<int>( qstrlen( name ))));
+    QHash<QByteArray, Stage>::iterator stage = this->m_stages.find( key );
+    if ( stage == this->m_stages.end()) {
+        const QByteArray copy( name );
+        stage = this->m_stages.insert( copy, Stage( copy ));
+    }
+    stage->calls++;
+    stage->nanoseconds += duration;
+    stage->allocations += allocations;
+
+    if ( !this->m_fileName.isEmpty())
+        this->m_events << event;
+}
+
+/**
+ * @brief Trace::stages returns per-stage totals
+ * @return
+ */
+QList<Trace::Stage> Trace::stages() const {
+    QMutexLocker locker( &this->m_mutex );
+    return this->m_stages.values();
+}
+
+/**
+ * @brief Trace::save writes collected stages as Chrome trace JSON
+ * @param fileName defaults to the file named by BURNINGICON_TRACE
+ * @return
+ */
+bool Trace::save( const QString &fileName ) {
+    const QString path( fileName.isEmpty() ? this->m_fileName : fileName );
+    QHash<quintptr, int> threads;
+    QJsonArray events;
+
+    if ( path.isEmpty())
+        return false;
+
+    QMutexLocker locker( &this->m_mutex );
+    foreach ( const Event &event, this->m_events ) {
+        QJsonObject object;
+
+        // number threads in order of appearance
+        if ( !threads.contains( event.thread ))
+            threads[event.thread] = threads.count();
+
+        object["name"] = QString::fromLatin1( event.name );
+        object["cat"] = "pipeline";
+        object["ph"] = "X";
+        object["ts"] = static_cast<double>( event.start ) / 1000.0;
+        object["dur"] = static_cast<double>( event.duration ) / 1000.0;
+        object["pid"] = static_cast<qint64>( QCoreApplication::applicationPid());
+        object["tid"] = threads[event.thread];
+        if ( MemoryUsage::countsAllocations()) {
+            QJsonObject args;
+            args["allocations"] = static_cast<double>( event.allocations );
+            object["args"] = args;
+        }
+        events << object;
+    }
+    locker.unlock();
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+
+    QSaveFile file( path );
+    if ( !file.open( QIODevice::WriteOnly ))
+        return false;
+
+    file.write( QJsonDocument( root ).toJson( QJsonDocument::Compact ));
+    return file.commit();
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+#pragma once
+
+//
+// includes
+//
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include "memoryusage.h"
+
+/**
+ * @brief The Trace_ namespace
+ *
+ * Tracing is off unless BURNINGICON_TRACE names an output file (Chrome
+ * trace JSON, loadable in chrome://tracing or Perfetto) or the logging
+ * rule "burningicon.trace.debug=true" is set (durations are logged).
+ * Per-stage totals alone are collected when BURNINGICON_STAGES is set
+ * (shown in the memory report) or when enabled programmatically (e.g.
+ * for command line memory reports).
+ */
+namespace Trace_ {
+const static QLoggingCategory Debug( "burningicon.trace", QtWarningMsg );
+#ifdef Q_CC_MSVC
+static constexpr const char *EnvironmentVariable = "BURNINGICON_TRACE";
+static constexpr const char *StagesVariable = "BURNINGICON_STAGES";
+#else
+static constexpr const char __attribute__((unused)) *EnvironmentVariable = "BURNINGICON_TRACE";
+static constexpr const char __attribute__((unused)) *StagesVariable = "BURNINGICON_STAGES";
+#endif
+}
+
+/**
+ * @brief The Trace class collects timed pipeline stages from any thread
+ *
+ * A process-wide instance (allowed in the core library as diagnostics only),
+ * so that scopes deep in the pipeline need no tracer passed through options.
+ */
+class Trace final {
+    Q_DISABLE_COPY( Trace )
+
+public:
+    /**
+     * @brief The Event struct (times in nanoseconds since start)
+     */
+    struct Event {
+        const char *name;
+        qint64 start;
+        qint64 duration;
+        quintptr thread;
+        quint64 allocations;
+    };
+
+    /**
+     * @brief The Stage struct accumulates all events of the same name
+     */
+    struct Stage {
+        QByteArray name;
+        int calls;
+        qint64 nanoseconds;
+        quint64 allocations;
+        explicit Stage( const QByteArray &n = QByteArray()) : name( n ), calls( 0 ), nanoseconds( 0 ), allocations( 0 ) {}
+    };
+
+    static Trace *instance() { static Trace instance; return &instance; }
+    ~Trace() = default;
+    bool isEnabled() const { return this->m_enabled; }
+    void setEnabled( bool enabled = true ) { this->m_enabled = enabled || this->m_log || !this->m_fileName.isEmpty(); }
+    qint64 elapsed() const { return this->m_timer.nsecsElapsed(); }
+    void add( const char *name, qint64 start, qint64 duration, quint64 allocations = 0 );
+    QList<Stage> stages() const;
+    bool save( const QString &fileName = QString());
+
+private:
+    Trace();
+    bool m_enabled;
+    bool m_log;
+    QString m_fileName;
+    QElapsedTimer m_timer;
+    mutable QMutex m_mutex;
+    QVector<Event> m_events;
+    QHash<QByteArray, Stage> m_stages;
+};
+
+/**
+ * @brief The TraceScope class times the enclosing block
+ *
+ * Names must be string literals (they are stored as pointers).
+ */
+class TraceScope final {
+    Q_DISABLE_COPY( TraceScope )
+
+public:
+    explicit TraceScope( const char *name ) : m_name( name ), m_start( Trace::instance()->isEnabled() ? Trace::instance()->elapsed() : -1 ), m_allocations( MemoryUsage::allocations()) {}
+    ~TraceScope() {
+        if ( this->m_start >= 0 )
+            Trace::instance()->add( this->m_name, this->m_start, Trace::instance()->elapsed() - this->m_start, MemoryUsage::allocations() - this->m_allocations );
+    }
+
+private:
+    const char *m_name;
+    qint64 m_start;
+    quint64 m_allocations;
+};
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "undocommands.h"
+#include "mainwindow.h"
+
+/**
+ * @brief LayerStateCommand::LayerStateCommand
+ * @param window
+ * @param layer
+ * @param state layer contents after the change
+ * @param text
+ * @param parent
+ */
+LayerStateCommand::LayerStateCommand( MainWindow *window, Layer *layer, const Layer &state, const QString &text, QUndoCommand *parent ) : QUndoCommand( text, parent ), window( window ), layer( layer ), state( state ) {}
+
+/**
+ * @brief LayerStateCommand::swap exchanges current and stored layer contents
+ */
+void LayerStateCommand::swap() {
+    const Layer current( *this->layer );
+
+    *this->layer = this->state;
+    this->state = current;
+    this->window->resetModel();
+}
+
+/**
+ * @brief RemoveLayerCommand::RemoveLayerCommand
+ * @param window
+ * @param layer
+ * @param parent
+ */
+RemoveLayerCommand::RemoveLayerCommand( MainWindow *window, Layer *layer, QUndoCommand *parent ) : QUndoCommand( parent ), window( window ), layer( layer ), removed( false ) {
+    this->setText( QObject::tr( "Remove %1x%1 layer" ).arg( layer->scale()));
+}
+
+/**
+ * @brief RemoveLayerCommand::~RemoveLayerCommand
+ */
+RemoveLayerCommand::~RemoveLayerCommand() {
+    if ( this->removed )
+        delete this->layer;
+}
+
+/**
+ * @brief RemoveLayerCommand::redo
+ */
+void RemoveLayerCommand::redo() {
+    this->window->takeLayer( this->layer );
+    this->removed = true;
+    this->window->resetModel();
+}
+
+/**
+ * @brief RemoveLayerCommand::undo
+ */
+void RemoveLayerCommand::undo() {
+    this->window->insertLayer( this->layer );
+    this->removed = false;
+    this->window->resetModel();
+}
+
+/**
+ * @brief DesignerPropertyCommand::DesignerPropertyCommand
+ * @param designer
+ * @param layer
+ * @param property
+ * @param before
+ * @param after
+ * @param drag slider drag serial (NoDrag for discrete edits, which are never merged)
+ * @param parent
+ */
+DesignerPropertyCommand::DesignerPropertyCommand( Designer *designer, DesignerLayer *layer, Designer::Properties property, const QVariant &before, const QVariant &after, int drag, QUndoCommand *parent ) :
+    QUndoCommand( parent ),
+    designer( designer ),
+    layer( layer ),
+    property( property ),
+    before( before ),
+    after( after ),
+    drag( drag ) {
+    this->setText( QObject::tr( "Change \"%1\"" ).arg( layer->name()));
+}
+
+/**
+ * @brief DesignerPropertyCommand::mergeWith collapses a slider drag into a single step
+ * @param other
+ * @return
+ */
+bool DesignerPropertyCommand::mergeWith( const QUndoCommand *other ) {
+    const DesignerPropertyCommand *command( static_cast<const DesignerPropertyCommand *>( other ));
+
+    if ( this->drag == UndoCommands_::NoDrag || command->drag != this->drag || command->layer != this->layer || command->property != this->property )
+        return false;
+
+    this->after = command->after;
+    return true;
+}
+
+/**
+ * @brief DesignerPropertyCommand::redo
+ */
+void DesignerPropertyCommand::redo() {
+    this->designer->applyProperty( this->layer, this->property, this->after );
+}
+
+/**
+ * @brief DesignerPropertyCommand::undo
+ */
+void DesignerPropertyCommand::undo() {
+    this->designer->applyProperty( this->layer, this->property, this->before );
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2018 Factory #12
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QUndoCommand>
+#include <QVariant>
+#include "designer.h"
+#include "layer.h"
+
+//
+// classes
+//
+class MainWindow;
+
+/**
+ * @brief The UndoCommands_ namespace
+ */
+namespace UndoCommands_ {
+constexpr static int Limit = 100;
+constexpr static int NoDrag = -1;
+
+/**
+ * @brief The Ids enum (commands with an id are merged within a single slider drag)
+ */
+enum Ids {
+    NoId = -1,
+    DesignerProperty
+};
+}
+
+/**
+ * @brief The LayerStateCommand class swaps a layer with a stored copy of it
+ *
+ * Layer copies share pixels (and pending decoders or payloads) implicitly, so
+ * both directions are constant time regardless of image size.
+ */
+class LayerStateCommand final : public QUndoCommand {
+public:
+    explicit LayerStateCommand( MainWindow *window, Layer *layer, const Layer &state, const QString &text, QUndoCommand *parent = nullptr );
+    void redo() override { this->swap(); }
+    void undo() override { this->swap(); }
+
+private:
+    void swap();
+    MainWindow *window;
+    Layer *layer;
+    Layer state;
+};
+
+/**
+ * @brief The RemoveLayerCommand class owns the layer while it is removed
+ */
+class RemoveLayerCommand final : public QUndoCommand {
+public:
+    explicit RemoveLayerCommand( MainWindow *window, Layer *layer, QUndoCommand *parent = nullptr );
+    ~RemoveLayerCommand() override;
+    void redo() override;
+    void undo() override;
+
+private:
+    MainWindow *window;
+    Layer *layer;
+    bool removed;
+};
+
+/**
+ * @brief The DesignerPropertyCommand class stores a property delta of a designer layer
+ */
+class DesignerPropertyCommand final : public QUndoCommand {
+public:
+    explicit DesignerPropertyCommand( Designer *designer, DesignerLayer *layer, Designer::Properties property, const QVariant &before, const QVariant &after, int drag = UndoCommands_::NoDrag, QUndoCommand *parent = nullptr );
+    int id() const override { return UndoCommands_::DesignerProperty; }
+    bool mergeWith( const QUndoCommand *other ) override;
+    void redo() override;
+    void undo() override;
+
+private:
+    Designer *designer;
+    DesignerLayer *layer;
+    Designer::Properties property;
+    QVariant before;
+    QVariant after;
+    int drag;
+};
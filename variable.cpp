@@ -32,7 +32,7 @@
 /**
  * @brief Variable::Variable
  */
-Variable::Variable() {
+Variable::Variable() : current( new VariableSnapshot()) {
     // update widgets on variable change
     this->connect( this, &Variable::valueChanged, [ this ]( const QString &key ) {
         foreach ( Widget *widget, this->boundVariables.values( key )) {
@@ -55,6 +55,23 @@ Variable::Variable() {
     } );
 }
 
+/**
+ * @brief Variable::publish swaps in a new snapshot with the current value of key
+ * @param key
+ *
+ * The previous snapshot is never modified; readers still holding it keep
+ * seeing the values their job started with.
+ */
+void Variable::publish( const QString &key ) {
+    VariableSnapshot *snapshot( new VariableSnapshot( *this->current ));
+
+    if ( this->list.contains( key ))
+        snapshot->values[key] = this->list[key]->value();
+
+    QMutexLocker locker( &this->snapshotMutex );
+    this->current = QSharedPointer<const VariableSnapshot>( snapshot );
+}
+
 /**
  * @brief Variable::~Variable
  */
@@ -21,7 +21,9 @@
 //
 // includes
 //
+#include <QHash>
 #include <QMap>
+#include <QMutex>
 #include <QString>
 #include <QMetaMethod>
 #include <QSignalMapper>
@@ -41,6 +43,31 @@ namespace Variable_ {
 //
 class Widget;
 class XMLTools;
+template<typename T> class Setting;
+
+/**
+ * @brief The VariableSnapshot class is an immutable copy of all variable values
+ *
+ * Snapshots are published by Variable on every change and never modified
+ * afterwards, so a worker can hold one for the duration of a job and read
+ * it without locking while the user keeps editing settings.
+ */
+class VariableSnapshot final {
+    friend class Variable;
+
+public:
+    VariableSnapshot() = default;
+    bool contains( const QString &key ) const { return this->values.contains( key ); }
+
+    template<typename T>
+    T value( const QString &key ) const { return qvariant_cast<T>( this->values.value( key )); }
+    int integer( const QString &key ) const { return this->value<int>( key ); }
+    bool isEnabled( const QString &key ) const { return this->value<bool>( key ); }
+    QString string( const QString &key ) const { return this->value<QString>( key ); }
+
+private:
+    QHash<QString, QVariant> values;
+};
 
 /**
  * @brief The Variable class
@@ -61,6 +88,7 @@ public:
      */
     static Variable *instance() { static Variable *instance( new Variable()); return instance; }
     bool contains( const QString &key ) const { return this->list.contains( key ); }
+    QSharedPointer<const VariableSnapshot> snapshot() const { QMutexLocker locker( &this->snapshotMutex ); return this->current; }
 
     template<typename T>
     T value( const QString &key, bool defaultValue = false ) { if ( !this->contains( key )) return QVariant().value<T>(); if ( defaultValue ) return qvariant_cast<T>( this->list[key]->defaultValue()); return qvariant_cast<T>( this->list[key]->value()); }
@@ -108,6 +136,7 @@ public:
         if ( initial ) {
             // initial read from configuration file
             Variable::instance()->list[key]->setValue( var );
+            Variable::instance()->publish( key );
         } else {
             QVariant currentValue;
 
@@ -119,6 +148,7 @@ public:
             // any subsequent value changes emit a valueChanged signal
             if ( value != currentValue ) {
                 Variable::instance()->list[key]->setValue( var );
+                Variable::instance()->publish( key );
                 emit valueChanged( key );
                 Variable::instance()->updateConnections( key, var );
             }
@@ -134,8 +164,30 @@ public:
     void add( const QString &key, const T &value, Var::Flags flags = Var::Flag::NoFlags ) {
         QVariant var( this->validate( value ));
 
-        if ( !Variable::instance()->list.contains( key ) && !key.isEmpty())
+        if ( !Variable::instance()->list.contains( key ) && !key.isEmpty()) {
             Variable::instance()->list[key] = Container( key, var, flags ).copy();
+            Variable::instance()->publish( key );
+        }
+    }
+
+    template<typename T>
+    Setting<T> addSetting( const QString &key, const T &value, Var::Flags flags = Var::Flag::NoFlags ) {
+        this->add<TypedVar<T>,T>( key, value, flags );
+        return this->setting<T>( key );
+    }
+
+    template<typename T>
+    Setting<T> setting( const QString &key ) const {
+        if ( !this->list.contains( key ))
+            return Setting<T>();
+
+        const TypedVar<T> *var = dynamic_cast<const TypedVar<T>*>( this->list[key].data());
+        if ( var == nullptr ) {
+            qCWarning( Variable_::Debug ) << "variable" << key << "was not registered as a typed setting";
+            return Setting<T>();
+        }
+
+        return Setting<T>( key, var->data());
     }
 
 public slots:
@@ -157,7 +209,37 @@ signals:
 
 private:
     explicit Variable();
+    void publish( const QString &key );
     QMap<QString, QSharedPointer<Var>> list;
+    QSharedPointer<const VariableSnapshot> current;
+    mutable QMutex snapshotMutex;
     QMultiMap<QString, Widget*> boundVariables;
     QMap<QString, QPair<QObject*, int> > slotList;
 };
+
+/**
+ * @brief The Setting class is a typed handle to a registered variable
+ *
+ * The key is resolved once on registration; reads are a plain dereference of
+ * the converted value kept by TypedVar. Writes go through Variable so that
+ * bound widgets and valueChanged listeners are still notified. Live reads are
+ * for the main thread only; workers read through a VariableSnapshot.
+ */
+template<typename T>
+class Setting final {
+    friend class Variable;
+
+public:
+    Setting() = default;
+    QString key() const { return this->m_key; }
+    bool isValid() const { return this->m_value != nullptr; }
+    const T &value() const { Q_ASSERT( this->isValid()); return *this->m_value; }
+    T value( const VariableSnapshot &snapshot ) const { return snapshot.value<T>( this->m_key ); }
+    operator const T &() const { return this->value(); }
+    void setValue( const T &value ) const { Variable::instance()->setValue<T>( this->m_key, value ); }
+
+private:
+    Setting( const QString &key, const T *value ) : m_key( key ), m_value( value ) {}
+    QString m_key;
+    const T *m_value = nullptr;
+};
@@ -27,7 +27,7 @@
 /**
  * @brief The Var class
  */
-class Var final {
+class Var {
 public:
     enum class Flag {
         NoFlags  = 0x0,
@@ -56,3 +56,18 @@ private:
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( Var::Flags )
+
+/**
+ * @brief The TypedVar class keeps a converted copy of the value next to the variant
+ */
+template<typename T>
+class TypedVar final : public Var {
+public:
+    explicit TypedVar( const QString &key = QString(), const QVariant &defaultValue = QVariant(), Flags flags = Flag::NoFlags ) : Var( key, defaultValue, flags ), m_typed( qvariant_cast<T>( defaultValue )) {}
+    void setValue( const QVariant &value ) override { Var::setValue( value ); this->m_typed = qvariant_cast<T>( value ); }
+    QSharedPointer<Var> copy() const override { return QSharedPointer<Var>( new TypedVar<T>( *this )); }
+    const T *data() const { return &this->m_typed; }
+
+private:
+    T m_typed;
+};
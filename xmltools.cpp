@@ -22,88 +22,158 @@
 #include "xmltools.h"
 #include "variable.h"
 #include <QBuffer>
+#include <QCryptographicHash>
 #include <QDataStream>
 #include <QDir>
-#include <QDomDocument>
 #include <QFile>
+#include <QSaveFile>
+#include <QTimer>
+#include <QXmlStreamReader>
 #include <QXmlStreamWriter>
+#include <QtConcurrent>
 #include "main.h"
 
 /**
- * @brief XMLTools::read
- * @param mode
- * @param object
+ * @brief XMLTools::XMLTools
+ * @param parent
  */
-void XMLTools::read() {
-    QString path;
-    QDomDocument document;
-    QDomNode node;
+XMLTools::XMLTools( QObject *parent ) : QObject( parent ), timer( new QTimer( this )) {
+    this->setObjectName( "XMLTools" );
+    GarbageMan::instance()->add( this );
+
+    // a single writer keeps saves ordered
+    this->pool.setMaxThreadCount( 1 );
+
+    // coalesce bursts of changes (sliders, spin boxes) into one save
+    this->timer->setSingleShot( true );
+    this->timer->setInterval( XMLTools_::SaveDelay );
+    this->connect( this->timer, &QTimer::timeout, this, &XMLTools::save );
+}
+
+/**
+ * @brief XMLTools::path returns configuration file path (creating its directory)
+ * @return
+ */
+QString XMLTools::path() {
     QDir configDir( QDir::homePath() + "/" + Main::Path );
 
     if ( !configDir.exists())
         configDir.mkpath( configDir.absolutePath());
 
-    // set path
-    path = configDir.absolutePath() + "/" + XMLTools_::ConfigFile;
+    return configDir.absolutePath() + "/" + XMLTools_::ConfigFile;
+}
 
-    // load xml file
-    QFile xmlFile( path );
+/**
+ * @brief XMLTools::read
+ */
+void XMLTools::read() {
+    QFile xmlFile( XMLTools::path());
 
-    if ( !xmlFile.exists() || !xmlFile.open( QFile::ReadOnly | QFile::Text )) {
+    if ( !xmlFile.exists() || !xmlFile.open( QFile::ReadOnly )) {
         qCCritical( XMLTools_::Debug ) << this->tr( "no configuration file found" );
         return;
     }
 
-    document.setContent( &xmlFile );
-    node = document.documentElement().firstChild();
-
-    while ( !node.isNull()) {
-        QDomElement element( node.toElement());
-
-        if ( !element.isNull()) {
-            if ( !QString::compare( element.tagName(), "variable" )) {
-                const QString key( element.attribute( "key" ));
-                QVariant value;
-
-                if ( element.hasAttribute( "binary" )) {
-                    QByteArray array( QByteArray::fromBase64( element.attribute( "binary" ).toUtf8().constData()));
-                    QBuffer buffer( &array );
-                    buffer.open( QIODevice::ReadOnly );
-                    QDataStream in( &buffer );
-                    in >> value;
-                } else {
-                    value = element.attribute( "value" );
-                }
-
-                if ( Variable::instance()->contains( key ) && !key.isEmpty())
-                    Variable::instance()->setValue( key, value, true );
+    const QByteArray data( xmlFile.readAll());
+    xmlFile.close();
+
+    // remember what is on disk, so an unchanged configuration is never rewritten
+    {
+        QMutexLocker locker( &this->mutex );
+        this->hash = QCryptographicHash::hash( data, QCryptographicHash::Sha1 );
+    }
+
+    QXmlStreamReader stream( data );
+    while ( stream.readNextStartElement()) {
+        // descend into the root element
+        if ( !QString::compare( stream.name().toString(), "configuration" ))
+            continue;
+
+        if ( !QString::compare( stream.name().toString(), "variable" )) {
+            const QXmlStreamAttributes attributes( stream.attributes());
+            const QString key( attributes.value( "key" ).toString());
+            QVariant value;
+
+            if ( attributes.hasAttribute( "binary" )) {
+                QByteArray array( QByteArray::fromBase64( attributes.value( "binary" ).toUtf8()));
+                QBuffer buffer( &array );
+                buffer.open( QIODevice::ReadOnly );
+                QDataStream in( &buffer );
+                in >> value;
+            } else {
+                value = attributes.value( "value" ).toString();
             }
+
+            if ( Variable::instance()->contains( key ) && !key.isEmpty())
+                Variable::instance()->setValue( key, value, true );
         }
-        node = node.nextSibling();
+
+        stream.skipCurrentElement();
     }
 
-    document.clear();
-    xmlFile.close();
+    if ( stream.hasError())
+        qCWarning( XMLTools_::Debug ) << this->tr( "malformed configuration file: %1" ).arg( stream.errorString());
+}
+
+/**
+ * @brief XMLTools::setAutoSave schedules a background save after each change
+ * @param enable
+ */
+void XMLTools::setAutoSave( bool enable ) {
+    if ( enable )
+        this->connect( Variable::instance(), &Variable::valueChanged, this->timer, static_cast<void( QTimer::* )()>( &QTimer::start ), Qt::UniqueConnection );
+    else
+        this->disconnect( Variable::instance(), &Variable::valueChanged, this->timer, nullptr );
+}
+
+/**
+ * @brief XMLTools::save serializes the current settings snapshot on the writer thread
+ */
+void XMLTools::save() {
+    const QSharedPointer<const VariableSnapshot> settings( Variable::instance()->snapshot());
+    const QStringList keys( XMLTools::saveableKeys());
+
+    QtConcurrent::run( &this->pool, [ this, settings, keys ]() {
+        this->store( XMLTools::serialize( *settings, keys ));
+    } );
 }
 
 /**
- * @brief XMLTools::write
- * @param mode
+ * @brief XMLTools::write writes pending changes synchronously (used on exit)
  */
 void XMLTools::write() {
-    QString path, savedData, newData;
-    QDir configDir( QDir::homePath() + "/" + Main::Path );
+    this->timer->stop();
+    this->pool.waitForDone();
+    this->store( XMLTools::serialize( *Variable::instance()->snapshot(), XMLTools::saveableKeys()));
+}
 
-    if ( !configDir.exists())
-        configDir.mkpath( configDir.absolutePath());
+/**
+ * @brief XMLTools::saveableKeys returns keys of persistent variables
+ * @return
+ */
+QStringList XMLTools::saveableKeys() {
+    QStringList keys;
+
+    foreach ( const QSharedPointer<Var> &var, Variable::instance()->list ) {
+        if ( var->key().isEmpty() || var->flags() & Var::Flag::NoSave )
+            continue;
+
+        keys << var->key();
+    }
 
-    // set path
-    path = configDir.absolutePath() + "/" + XMLTools_::ConfigFile;
+    return keys;
+}
 
-    // read xml file and create buffer
-    QFile xmlFile( path );
-    QBuffer xmlBuffer;
-    xmlBuffer.open( QBuffer::WriteOnly | QBuffer::Text | QBuffer::Truncate );
+/**
+ * @brief XMLTools::serialize builds the configuration document from a snapshot
+ * @param settings
+ * @param keys
+ * @return
+ */
+QByteArray XMLTools::serialize( const VariableSnapshot &settings, const QStringList &keys ) {
+    QByteArray data;
+    QBuffer xmlBuffer( &data );
+    xmlBuffer.open( QBuffer::WriteOnly );
 
     // create stream
     QXmlStreamWriter stream( &xmlBuffer );
@@ -112,61 +182,55 @@ void XMLTools::write() {
     stream.writeStartElement( "configuration" );
     stream.writeAttribute( "version", "3" );
 
-    // switch mode
-    foreach ( const QSharedPointer<Var> &var, Variable::instance()->list ) {
-        if ( var->key().isEmpty() || var->flags() & Var::Flag::NoSave )
-            continue;
+    foreach ( const QString &key, keys ) {
+        const QVariant value( settings.value<QVariant>( key ));
 
         stream.writeEmptyElement( "variable" );
-        stream.writeAttribute( "key", var->key());
+        stream.writeAttribute( "key", key );
 
-        if ( !var->value().canConvert<QString>()) {
+        if ( !value.canConvert<QString>()) {
             QByteArray array;
-            QBuffer buffer(&array);
+            QBuffer buffer( &array );
 
             buffer.open( QIODevice::WriteOnly );
             QDataStream out( &buffer );
 
-            out << var->value();
+            out << value;
             buffer.close();
 
             stream.writeAttribute( "binary", QString( array.toBase64()));
         } else {
-            stream.writeAttribute( "value", var->value().toString());
+            stream.writeAttribute( "value", value.toString());
         }
     }
 
-    // end config element
+    // end config element and document
     stream.writeEndElement();
-
-    // end document
     stream.writeEndDocument();
-
-    // close buffer
     xmlBuffer.close();
 
-    // read existing config from file
-    if ( xmlFile.open( QFile::ReadOnly | QIODevice::Text )) {
-        savedData = xmlFile.readAll();
-        xmlFile.close();
-    }
+    return data;
+}
 
-    // read new config from buffer
-    if ( xmlBuffer.open( QFile::ReadOnly | QIODevice::Text )) {
-        newData = xmlBuffer.readAll();
-        xmlBuffer.close();
-    }
+/**
+ * @brief XMLTools::store writes data unless identical to what is on disk
+ * @param data
+ *
+ * The file is replaced through a temporary file and an atomic rename, so a
+ * crash mid-write never leaves a truncated configuration behind.
+ */
+void XMLTools::store( const QByteArray &data ) {
+    const QByteArray hash( QCryptographicHash::hash( data, QCryptographicHash::Sha1 ));
+    QMutexLocker locker( &this->mutex );
 
-    // compare data
-    if ( QString::compare( savedData, newData )) {
-        // write out as binary (not QIODevice::Text) to avoid CR line endings
-        if ( !xmlFile.open( QFile::WriteOnly | QFile::Truncate )) {
-            qCCritical( XMLTools_::Debug ) << this->tr( "could not open configuration file \"%1\"" ).arg( path );
-            return;
-        }
-        xmlFile.write( newData.toUtf8().replace( "\r", "" ));
+    if ( hash == this->hash )
+        return;
+
+    QSaveFile xmlFile( XMLTools::path());
+    if ( !xmlFile.open( QIODevice::WriteOnly ) || xmlFile.write( data ) != data.size() || !xmlFile.commit()) {
+        qCCritical( XMLTools_::Debug ) << XMLTools::tr( "could not write configuration file \"%1\"" ).arg( xmlFile.fileName());
+        return;
     }
 
-    // close file
-    xmlFile.close();
+    this->hash = hash;
 }
@@ -25,6 +25,8 @@
 #include <QDir>
 #include <QLoggingCategory>
 #include <QMap>
+#include <QMutex>
+#include <QThreadPool>
 
 /**
  * @brief The XML namespace
@@ -36,8 +38,15 @@ static constexpr const char *ConfigFile( "configuration.xml" );
 static constexpr const char __attribute__((unused)) *ConfigFile( "configuration.xml" );
 #endif
 const static QLoggingCategory Debug( "xml" );
+constexpr int SaveDelay = 1000;
 }
 
+//
+// classes
+//
+class QTimer;
+class VariableSnapshot;
+
 /**
  * @brief The XMLTools class
  */
@@ -50,7 +59,19 @@ public:
     static XMLTools *instance() { static XMLTools *instance( new XMLTools()); return instance; }
     void write();
     void read();
+    void setAutoSave( bool enable = true );
+
+private slots:
+    void save();
 
 private:
-    explicit XMLTools( QObject *parent = nullptr ) : QObject( parent ) { this->setObjectName( "XMLTools" ); GarbageMan::instance()->add( this ); }
+    explicit XMLTools( QObject *parent = nullptr );
+    static QString path();
+    static QStringList saveableKeys();
+    static QByteArray serialize( const VariableSnapshot &settings, const QStringList &keys );
+    void store( const QByteArray &data );
+    QTimer *timer;
+    QThreadPool pool;
+    QMutex mutex;
+    QByteArray hash;
 };